@@ -1,6 +1,7 @@
 #pragma once
 
 #include <morphotree/core/alias.hpp>
+#include <type_traits>
 #include <vector>
 
 namespace morphotree
@@ -10,6 +11,28 @@ namespace morphotree
   public:
     virtual std::vector<uint32> neighbours(uint32 v) const = 0;
 
+    // calls "visit" on every neighbour of "v", in the order of neighbours(v).
+    // The adjacencies of the library hide it with a version which does not
+    // allocate; this one is the fallback for any other adjacency, used when
+    // an algorithm templated on the adjacency type gets an Adjacency.
+    template<class Visitor>
+    inline void forEachNeighbour(uint32 v, Visitor &&visit) const
+    {
+      for (uint32 n : neighbours(v))
+        visit(n);
+    }
+
     virtual ~Adjacency() {}
   };
+
+  // restricts a template on the adjacency type to the classes derived from
+  // Adjacency, so that overloads taking a std::shared_ptr<Adjacency> are still
+  // chosen for smart pointers.
+  template<class AdjacencyType>
+  using RequireAdjacency = typename std::enable_if<
+    std::is_base_of<Adjacency, AdjacencyType>::value>::type;
+
+  // connectivity of the pixel grid for the builders which read the image
+  // in pieces (tiles or rows) and so connect the pieces themselves.
+  enum class GridConnectivity { Adjacency4C, Adjacency8C };
 }
\ No newline at end of file
@@ -16,9 +16,15 @@ namespace morphotree
 
     std::vector<uint32> neighbours(uint32 v) const;
 
+    // calls "visit" on the neighbours of "v" inside the domain, in the
+    // order of neighbours(v), without allocating.
+    template<class Visitor>
+    inline void forEachNeighbour(uint32 v, Visitor &&visit) const;
+
   protected:
     Box domain_;  
     std::array<I32Point, 8> offset_;
+    std::array<int32, 8> indexOffset_;
   };
 
   class InfAdjacency8C : public Adjacency
@@ -26,9 +32,42 @@ namespace morphotree
   public:
     InfAdjacency8C(Box imgdomain);
     std::vector<uint32> neighbours(uint32 v) const;
+
+    // calls "visit" on the neighbours of "v", with Box::UndefinedIndex for
+    // those outside the domain, without allocating.
+    template<class Visitor>
+    inline void forEachNeighbour(uint32 v, Visitor &&visit) const;
   
   protected:
     Box domain_;
     std::array<I32Point, 8> offset_;
+    std::array<int32, 8> indexOffset_;
   };
+
+  // =============== [IMPLEMENTATION] ==================================================
+  template<class Visitor>
+  void Adjacency8C::forEachNeighbour(uint32 v, Visitor &&visit) const
+  {
+    const int32 width = domain_.width(), height = domain_.height();
+    const int32 x = static_cast<int32>(v) % width, y = static_cast<int32>(v) / width;
+    for (uint32 i = 0; i < offset_.size(); i++) {
+      int32 nx = x + offset_[i].x(), ny = y + offset_[i].y();
+      if (0 <= nx && nx < width && 0 <= ny && ny < height)
+        visit(static_cast<uint32>(static_cast<int32>(v) + indexOffset_[i]));
+    }
+  }
+
+  template<class Visitor>
+  void InfAdjacency8C::forEachNeighbour(uint32 v, Visitor &&visit) const
+  {
+    const int32 width = domain_.width(), height = domain_.height();
+    const int32 x = static_cast<int32>(v) % width, y = static_cast<int32>(v) / width;
+    for (uint32 i = 0; i < offset_.size(); i++) {
+      int32 nx = x + offset_[i].x(), ny = y + offset_[i].y();
+      if (0 <= nx && nx < width && 0 <= ny && ny < height)
+        visit(static_cast<uint32>(static_cast<int32>(v) + indexOffset_[i]));
+      else
+        visit(static_cast<uint32>(Box::UndefinedIndex));
+    }
+  }
 }
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "morphotree/adjacency/adjacency.hpp"
+#include "morphotree/adjacency/adjacency4c.hpp"
+#include "morphotree/adjacency/adjacency8c.hpp"
+#include "morphotree/adjacency/adjacencyuc.hpp"
+
+#include <typeinfo>
+
+namespace morphotree
+{
+  // Calls "fn" with "adj" cast to its dynamic type when it is one of the
+  // adjacencies of the library, so that an algorithm templated on the
+  // adjacency type runs with their inline forEachNeighbour. Any other
+  // adjacency, including classes derived from the ones of the library, is
+  // passed as an Adjacency and goes through the virtual neighbours().
+  template<class Function>
+  auto withStaticAdjacency(const Adjacency &adj, Function &&fn) -> decltype(fn(adj))
+  {
+    const std::type_info &type = typeid(adj);
+    if (type == typeid(Adjacency4C))
+      return fn(static_cast<const Adjacency4C&>(adj));
+    if (type == typeid(Adjacency8C))
+      return fn(static_cast<const Adjacency8C&>(adj));
+    if (type == typeid(AdjacencyUC))
+      return fn(static_cast<const AdjacencyUC&>(adj));
+    if (type == typeid(InfAdjacency4C))
+      return fn(static_cast<const InfAdjacency4C&>(adj));
+    if (type == typeid(InfAdjacency8C))
+      return fn(static_cast<const InfAdjacency8C&>(adj));
+    return fn(adj);
+  }
+}
\ No newline at end of file
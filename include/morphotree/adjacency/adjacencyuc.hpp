@@ -4,6 +4,9 @@
 #include "morphotree/core/box.hpp"
 #include "morphotree/core/point.hpp"
 
+#include <vector>
+#include <array>
+
 namespace morphotree 
 {
 
@@ -37,9 +40,42 @@ namespace morphotree
     inline DiagonalConnection  dconn(uint32 v) const { return dconn_[v]; }
     inline void dconn(uint32 v, DiagonalConnection dconn) { dconn_[v] = dconn_[v] | dconn; }
 
+    // sets every diagonal connection back to None.
+    void clearDiagonalConnections();
+
+    // calls "visit" on the neighbours of "v" inside the domain, in the
+    // order of neighbours(v), without allocating.
+    template<class Visitor>
+    inline void forEachNeighbour(uint32 v, Visitor &&visit) const;
+
   protected:
     Box domain_;
     std::array<I32Point, 4> offset_;
+    std::array<I32Point, 4> diagonalOffset_;
+    std::array<DiagonalConnection, 4> diagonal_;
+    std::array<int32, 8> indexOffset_;
     std::vector<DiagonalConnection> dconn_;
   };
+
+  // =============== [IMPLEMENTATION] ==================================================
+  template<class Visitor>
+  void AdjacencyUC::forEachNeighbour(uint32 v, Visitor &&visit) const
+  {
+    const int32 width = domain_.width(), height = domain_.height();
+    const int32 x = static_cast<int32>(v) % width, y = static_cast<int32>(v) / width;
+    for (uint32 i = 0; i < offset_.size(); i++) {
+      int32 nx = x + offset_[i].x(), ny = y + offset_[i].y();
+      if (0 <= nx && nx < width && 0 <= ny && ny < height)
+        visit(static_cast<uint32>(static_cast<int32>(v) + indexOffset_[i]));
+    }
+
+    DiagonalConnection curDconn = dconn_[v];
+    for (uint32 i = 0; i < diagonal_.size(); i++) {
+      if (!(curDconn & diagonal_[i]))
+        continue;
+      int32 nx = x + diagonalOffset_[i].x(), ny = y + diagonalOffset_[i].y();
+      if (0 <= nx && nx < width && 0 <= ny && ny < height)
+        visit(static_cast<uint32>(static_cast<int32>(v) + indexOffset_[offset_.size() + i]));
+    }
+  }
 }
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+#include "morphotree/core/box.hpp"
+#include "morphotree/adjacency/adjacency.hpp"
+
+#include <vector>
+#include <array>
+
+namespace morphotree
+{
+  // 4- and 8-adjacencies on the padded indices of a PaddedImage of "domain",
+  // with the neighbours in the order of Adjacency4C and Adjacency8C. A
+  // neighbour is a fixed linear offset away, with no bounds check: they are
+  // only defined for the padded indices of the pixels of the domain, whose
+  // neighbours are pixels or elements of the border.
+  class PaddedAdjacency4C : public Adjacency
+  {
+  public:
+    PaddedAdjacency4C(Box imgdomain);
+
+    std::vector<uint32> neighbours(uint32 v) const;
+
+    template<class Visitor>
+    inline void forEachNeighbour(uint32 v, Visitor &&visit) const
+    {
+      for (int32 offset : offset_)
+        visit(static_cast<uint32>(static_cast<int32>(v) + offset));
+    }
+
+  protected:
+    std::array<int32, 4> offset_;
+  };
+
+  class PaddedAdjacency8C : public Adjacency
+  {
+  public:
+    PaddedAdjacency8C(Box imgdomain);
+
+    std::vector<uint32> neighbours(uint32 v) const;
+
+    template<class Visitor>
+    inline void forEachNeighbour(uint32 v, Visitor &&visit) const
+    {
+      for (int32 offset : offset_)
+        visit(static_cast<uint32>(static_cast<int32>(v) + offset));
+    }
+
+  protected:
+    std::array<int32, 8> offset_;
+  };
+}
\ No newline at end of file
@@ -6,12 +6,12 @@
 
 namespace morphotree
 {
-  template<class ValueType>
-  class AreaComputer : public AttributeComputer<uint32, ValueType>
+  template<class ValueType, class IndexType = uint32>
+  class AreaComputer : public AttributeComputer<uint32, ValueType, IndexType>
   {
   public:
     using AttrType = uint32;
-    using TreeType = typename AttributeComputer<uint32, ValueType>::TreeType;
+    using TreeType = typename AttributeComputer<uint32, ValueType, IndexType>::TreeType;
     using NodePtr = typename TreeType::NodePtr;
     
 
@@ -22,23 +22,23 @@ namespace morphotree
 
 
   // ========================== [Implementation] ===============================================
-  template<class ValueType>
-  std::vector<uint32> AreaComputer<ValueType>::initAttributes(
-    const AreaComputer<ValueType>::TreeType &tree)
+  template<class ValueType, class IndexType>
+  std::vector<uint32> AreaComputer<ValueType, IndexType>::initAttributes(
+    const AreaComputer<ValueType, IndexType>::TreeType &tree)
   {
     return std::vector<uint32>(tree.numberOfNodes(), 0);
   }
 
-  template<class ValueType>
-  void AreaComputer<ValueType>::computeInitialValue(std::vector<uint32> &attr, 
-    AreaComputer<ValueType>::NodePtr node)
+  template<class ValueType, class IndexType>
+  void AreaComputer<ValueType, IndexType>::computeInitialValue(std::vector<uint32> &attr, 
+    AreaComputer<ValueType, IndexType>::NodePtr node)
   {
     attr[node->id()] += node->cnps().size(); 
   }
 
-  template<class ValueType>
-  void AreaComputer<ValueType>::mergeToParent(std::vector<uint32> &attr,
-    AreaComputer<ValueType>::NodePtr node, AreaComputer<ValueType>::NodePtr parent)
+  template<class ValueType, class IndexType>
+  void AreaComputer<ValueType, IndexType>::mergeToParent(std::vector<uint32> &attr,
+    AreaComputer<ValueType, IndexType>::NodePtr node, AreaComputer<ValueType, IndexType>::NodePtr parent)
   {
     attr[parent->id()] += attr[node->id()];
   }
@@ -5,12 +5,15 @@
 
 namespace morphotree 
 {
-  template<class AttrType, class ValueType>
+  // IndexType is the index type of the trees (see MorphologicalTree), so
+  // that the trees of withNarrowestMaxTree and withNarrowestMinTree get
+  // their attributes too.
+  template<class AttrType, class ValueType, class IndexType = uint32>
   class AttributeComputer
   {
   public:
-    using NodePtr = typename MorphologicalTree<ValueType>::NodePtr;
-    using TreeType = MorphologicalTree<ValueType>;
+    using NodePtr = typename MorphologicalTree<ValueType, IndexType>::NodePtr;
+    using TreeType = MorphologicalTree<ValueType, IndexType>;
     using AttributeType = AttrType;
 
     std::vector<AttrType> computeAttribute(const TreeType &tree);
@@ -24,16 +27,16 @@ namespace morphotree
   };
 
   // ========================= [Implementation] ===============================================================
-  template<class AttrType, class ValueType>
-  std::vector<AttrType> AttributeComputer<AttrType, ValueType>::computeAttribute(
-    const MorphologicalTree<ValueType> &tree)
+  template<class AttrType, class ValueType, class IndexType>
+  std::vector<AttrType> AttributeComputer<AttrType, ValueType, IndexType>::computeAttribute(
+    const MorphologicalTree<ValueType, IndexType> &tree)
   {
-    using TreeType = MorphologicalTree<ValueType>; 
+    using TreeType = MorphologicalTree<ValueType, IndexType>; 
     using NodePtr = typename TreeType::NodePtr;
 
     std::vector<AttrType> attr = initAttributes(tree);
 
-    tree.tranverse([this, &attr](NodePtr node){
+    tree.forEachPostOrder([this, &attr](NodePtr node){
       this->computeInitialValue(attr, node);
       if (node->parent() != nullptr)
         this->mergeToParent(attr, node, node->parent());
@@ -44,4 +47,3 @@ namespace morphotree
     return attr;
   }
 }
-
@@ -3,6 +3,7 @@
 #include "morphotree/core/alias.hpp"
 #include "morphotree/attributes/attributeComputer.hpp"
 #include "morphotree/attributes/bitquads/quads.hpp"
+#include "morphotree/core/paddedImage.hpp"
 
 #include <fstream>
 #include <array>
@@ -20,6 +21,11 @@ namespace morphotree
     CTreeQuadCountsComputer(Box domain, const std::vector<ValueType> &image,
       const std::string &dtFilename);
 
+    // the border of "image" is lower (max-tree) or greater (min-tree) than
+    // every pixel, whatever its sentinel, as in the constructor above.
+    CTreeQuadCountsComputer(const PaddedImage<ValueType> &image,
+      const std::string &dtFilename);
+
     std::vector<Quads> initAttributes(const TreeType &tree);
     void computeInitialValue(std::vector<Quads> &attr, NodePtr node);
     void mergeToParent(std::vector<Quads> &attr, NodePtr node, NodePtr parent);
@@ -27,6 +33,7 @@ namespace morphotree
   private:
     void readDecisionTree(const std::string &dtFilename);
     const std::array<int8, 9>& getCountsFromDT(const I32Point &p);
+    const std::array<int8, 9>& getCountsFromDTPadded(uint32 pp) const;
 
     bool isLower(const I32Point &p, const I32Point &q) const;
     bool isGreater(const I32Point &p, const I32Point &q) const;
@@ -39,6 +46,8 @@ namespace morphotree
     std::array<std::array<int8, 9>, NUM_DT_LEAVES> dt_;
     const std::vector<ValueType> &image_;
     Box domain_;
+    const PaddedImage<ValueType> *padded_;
+    std::array<int32, 8> paddedOffsets_;
   };
 
   // ============== [implementation ] ====================================================
@@ -52,11 +61,21 @@ namespace morphotree
   template<class ValueType>
   CTreeQuadCountsComputer<ValueType>::CTreeQuadCountsComputer(Box domain, 
     const std::vector<ValueType> &image, const std::string &dtFilename)
-    :domain_{domain}, image_{image}
+    :domain_{domain}, image_{image}, padded_{nullptr}
   {
     readDecisionTree(dtFilename);    
   } 
 
+  template<class ValueType>
+  CTreeQuadCountsComputer<ValueType>::CTreeQuadCountsComputer(
+    const PaddedImage<ValueType> &image, const std::string &dtFilename)
+    :domain_{image.domain()}, image_{image.values()}, padded_{&image}
+  {
+    for (uint32 i = 0; i < offsets.size(); i++)
+      paddedOffsets_[i] = image.offset(offsets[i]);
+    readDecisionTree(dtFilename);
+  }
+
   template<class ValueType>
   void CTreeQuadCountsComputer<ValueType>::readDecisionTree(const std::string &dtFilename)
   {
@@ -80,7 +99,9 @@ namespace morphotree
   void CTreeQuadCountsComputer<ValueType>::computeInitialValue(std::vector<Quads> &attr, NodePtr node)
   {
     for (uint32 pidx : node->cnps()) {
-      const std::array<int8, 9> &c = getCountsFromDT(domain_.indexToPoint(pidx));
+      const std::array<int8, 9> &c = padded_ != nullptr
+        ? getCountsFromDTPadded(padded_->paddedIndex(pidx))
+        : getCountsFromDT(domain_.indexToPoint(pidx));
       attr[node->id()].q1() += c[Quads::P1] - c[Quads::P1T]; 
       attr[node->id()].q2() += c[Quads::P2] - c[Quads::P2T];
       attr[node->id()].q3() += c[Quads::P3] - c[Quads::P3T];
@@ -117,6 +138,23 @@ namespace morphotree
     return dt_[idt];
   }
 
+  template<class ValueType>
+  const std::array<int8, 9>& CTreeQuadCountsComputer<ValueType>::getCountsFromDTPadded(
+    uint32 pp) const
+  {
+    // same coding as getCountsFromDT, accumulated as a base 3 number.
+    const uint32 borderCode = treeType_ == MorphoTreeType::MaxTree ? 0
+      : (treeType_ == MorphoTreeType::MinTree ? 2 : 1);
+    const ValueType v = (*padded_)[pp];
+    uint32 idt = 0;
+    for (int32 offset : paddedOffsets_) {
+      ValueType q = (*padded_)[pp + offset];
+      uint32 code = padded_->isBorder(pp + offset) ? borderCode : (q < v ? 0 : (q > v ? 2 : 1));
+      idt = 3 * idt + code;
+    }
+    return dt_[idt];
+  }
+
   template<class ValueType>
   bool CTreeQuadCountsComputer<ValueType>::isLower(const I32Point &p, const I32Point &q) const
   {
@@ -10,12 +10,12 @@
 
 namespace morphotree
 {
-  template<class ValueType>
-  class BoundingBoxComputer : public AttributeComputer<Box, ValueType>
+  template<class ValueType, class IndexType = uint32>
+  class BoundingBoxComputer : public AttributeComputer<Box, ValueType, IndexType>
   {
   public:
     using AttrType = Box;
-    using TreeType = typename AttributeComputer<Box, ValueType>::TreeType;
+    using TreeType = typename AttributeComputer<Box, ValueType, IndexType>::TreeType;
     using NodePtr = typename TreeType::NodePtr;
 
     BoundingBoxComputer(Box domain);
@@ -29,18 +29,18 @@ namespace morphotree
   };
 
   // ======================= [ IMPLEMENTATION ] ================================================
-  template<class ValueType>
-  BoundingBoxComputer<ValueType>::BoundingBoxComputer(Box domain)
+  template<class ValueType, class IndexType>
+  BoundingBoxComputer<ValueType, IndexType>::BoundingBoxComputer(Box domain)
     :domain_{domain}
   {}
 
-  template<class ValueType>
-  std::vector<typename BoundingBoxComputer<ValueType>::AttrType>
-    BoundingBoxComputer<ValueType>::initAttributes(const TreeType &tree)
+  template<class ValueType, class IndexType>
+  std::vector<typename BoundingBoxComputer<ValueType, IndexType>::AttrType>
+    BoundingBoxComputer<ValueType, IndexType>::initAttributes(const TreeType &tree)
   {
     std::vector<AttrType> attr(tree.numberOfNodes(), Box());
 
-    tree.tranverse([&attr, this](NodePtr node) {
+    tree.forEachPostOrder([&attr, this](NodePtr node) {
       int32 xmin = std::numeric_limits<int32>::max();
       int32 ymin = std::numeric_limits<int32>::max();
 
@@ -62,13 +62,13 @@ namespace morphotree
     return attr;
   }
 
-  template<class ValueType>
-  void BoundingBoxComputer<ValueType>::computeInitialValue(std::vector<AttrType> &attr, 
+  template<class ValueType, class IndexType>
+  void BoundingBoxComputer<ValueType, IndexType>::computeInitialValue(std::vector<AttrType> &attr, 
     NodePtr node)
   { }
 
-  template<class ValueType>
-  void BoundingBoxComputer<ValueType>::mergeToParent(std::vector<AttrType> &attr, 
+  template<class ValueType, class IndexType>
+  void BoundingBoxComputer<ValueType, IndexType>::mergeToParent(std::vector<AttrType> &attr, 
     NodePtr node, NodePtr parent)
   {
     int32 left = attr[parent->id()].left();
@@ -1,6 +1,7 @@
 #pragma once 
 
 #include "morphotree/adjacency/adjacency.hpp"
+#include "morphotree/adjacency/adjacencyDispatch.hpp"
 #include "morphotree/core/box.hpp"
 #include "morphotree/tree/mtree.hpp"
 
@@ -99,30 +100,32 @@ namespace morphotree
     std::vector<std::unordered_set<uint32>> contours(tree.numberOfNodes());
     std::vector<uint8> ncount(domain.numberOfPoints());
 
-    tree.tranverse([&f, &contours, &ncount, adj](NodePtr node){
+    withStaticAdjacency(*adj, [&](const auto &a) {
+      tree.forEachPostOrder([&f, &contours, &ncount, &a](NodePtr node){
       
-      // Initialise contours of node "N"
-      std::unordered_set<uint32> &Ncontour = contours[node->id()];
-      for (NodePtr c : node->children()) {
-        for (uint32 pidx : contours[c->id()])
-          Ncontour.insert(pidx);
-      }
-
-      for (uint32 pidx : node->cnps()) {
-        for (uint32 qidx : adj->neighbours(pidx)) {
-          if (qidx == Box::UndefinedIndex || f[pidx] > f[qidx]) 
-            ncount[pidx]++;
-          else if (f[pidx] < f[qidx]) {
-            ncount[qidx]--;
-
-            if (ncount[qidx] == 0) 
-              Ncontour.erase(qidx);
-          }
+        // Initialise contours of node "N"
+        std::unordered_set<uint32> &Ncontour = contours[node->id()];
+        for (NodePtr c : node->children()) {
+          for (uint32 pidx : contours[c->id()])
+            Ncontour.insert(pidx);
         }
 
-        if (ncount[pidx] > 0)
-          Ncontour.insert(pidx);
-      }
+        for (uint32 pidx : node->cnps()) {
+          a.forEachNeighbour(pidx, [&](uint32 qidx) {
+            if (qidx == Box::UndefinedIndex || f[pidx] > f[qidx]) 
+              ncount[pidx]++;
+            else if (f[pidx] < f[qidx]) {
+              ncount[qidx]--;
+
+              if (ncount[qidx] == 0) 
+                Ncontour.erase(qidx);
+            }
+          });
+
+          if (ncount[pidx] > 0)
+            Ncontour.insert(pidx);
+        }
+      });
     });
     
     return contours;
@@ -140,4 +143,4 @@ namespace morphotree
     return bimg;
   }
 
-}
+}
\ No newline at end of file
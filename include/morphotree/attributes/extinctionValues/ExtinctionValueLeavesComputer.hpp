@@ -8,11 +8,11 @@
 
 namespace morphotree
 {
-  template<class ValueType, class AttrType>
+  template<class ValueType, class AttrType, class IndexType = uint32>
   class ExtinctionValueLeavesComputer
   {
   public:
-    using MTree = MorphologicalTree<ValueType>;
+    using MTree = MorphologicalTree<ValueType, IndexType>;
     using NodePtr = typename MTree::NodePtr;
     using MapType = std::unordered_map<uint32, AttrType>;
 
@@ -29,17 +29,17 @@ namespace morphotree
 
 
   // ===================== [ IMPLEMENTATION ] =============================================
-  template<class ValueType, class AttrType>
-  const AttrType ExtinctionValueLeavesComputer<ValueType, AttrType>::INF = 
+  template<class ValueType, class AttrType, class IndexType>
+  const AttrType ExtinctionValueLeavesComputer<ValueType, AttrType, IndexType>::INF = 
     std::numeric_limits<AttrType>::max();
 
 
-  template<class ValueType, class AttrType>
-  std::vector<typename ExtinctionValueLeavesComputer<ValueType, AttrType>::NodePtr> 
-    ExtinctionValueLeavesComputer<ValueType, AttrType>::extractLeaves(const MTree &tree) const
+  template<class ValueType, class AttrType, class IndexType>
+  std::vector<typename ExtinctionValueLeavesComputer<ValueType, AttrType, IndexType>::NodePtr> 
+    ExtinctionValueLeavesComputer<ValueType, AttrType, IndexType>::extractLeaves(const MTree &tree) const
   {
     std::vector<NodePtr> leaves;
-    tree.tranverse([&leaves](NodePtr node) {
+    tree.forEachPostOrder([&leaves](NodePtr node) {
       if (node->children().size() <= 0) { // is it a leaf? 
         leaves.push_back(node);
       }
@@ -48,13 +48,11 @@ namespace morphotree
     return leaves;
   }
 
-  template<class ValueType, class AttrType>
+  template<class ValueType, class AttrType, class IndexType>
   std::unordered_map<uint32, AttrType> 
-    ExtinctionValueLeavesComputer<ValueType, AttrType>::compute(const MTree &tree,
+    ExtinctionValueLeavesComputer<ValueType, AttrType, IndexType>::compute(const MTree &tree,
       const std::vector<AttrType> &attr) const
   {
-    using ChildItr = typename std::list<NodePtr>::iterator;
-
     std::vector<NodePtr> leaves = extractLeaves(tree);
     std::vector<bool> visited(tree.numberOfNodes(), false);
     std::unordered_map<uint32, AttrType> extinctionValues;
@@ -71,14 +69,14 @@ namespace morphotree
           
           // verify whether we have a tie or the extinction value 
           // can already be computed
-          std::list<NodePtr> children = Np->children();
-          for (ChildItr citr = children.begin(); citr != children.end() && shouldContinue; citr++) {
-            NodePtr Nc = *citr;
-            if ((visited[Nc->id()] && Nc->id() != Na->id() && attr[Nc->id()] == attr[Na->id()]) || 
-              (Nc->id() != Na->id() && attr[Nc->id()] > attr[Na->id()])) {
+          Span<const IndexType> children = tree.children(Np->id());
+          for (const IndexType *citr = children.begin(); citr != children.end() && shouldContinue; citr++) {
+            uint32 c = *citr;
+            if ((visited[c] && c != Na->id() && attr[c] == attr[Na->id()]) || 
+              (c != Na->id() && attr[c] > attr[Na->id()])) {
                 shouldContinue = false;
               }              
-            visited[Nc->id()] = true;
+            visited[c] = true;
           }
         }
         // Move to parent.
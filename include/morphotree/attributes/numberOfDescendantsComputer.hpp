@@ -5,12 +5,12 @@
 
 namespace morphotree
 {
-  template<class ValueType>
-  class NumberOfDescendantsComputer : public AttributeComputer<uint32, ValueType>
+  template<class ValueType, class IndexType = uint32>
+  class NumberOfDescendantsComputer : public AttributeComputer<uint32, ValueType, IndexType>
   {
   public:
     using AttrType = uint32;
-    using TreeType = typename AttributeComputer<AttrType, ValueType>::TreeType;
+    using TreeType = typename AttributeComputer<AttrType, ValueType, IndexType>::TreeType;
     using NodePtr = typename TreeType::NodePtr;
 
     std::vector<AttrType> initAttributes(const TreeType &tree);
@@ -19,22 +19,22 @@ namespace morphotree
   };
 
   // ========================= [ IMPLEMENTATION ] =========================================
-  template<class ValueType>
-  std::vector<typename NumberOfDescendantsComputer<ValueType>::AttrType> 
-    NumberOfDescendantsComputer<ValueType>::initAttributes(const TreeType &tree)
+  template<class ValueType, class IndexType>
+  std::vector<typename NumberOfDescendantsComputer<ValueType, IndexType>::AttrType> 
+    NumberOfDescendantsComputer<ValueType, IndexType>::initAttributes(const TreeType &tree)
   {
     return std::vector<AttrType>(tree.numberOfNodes(), 0);
   }
 
-  template<class ValueType>
-  void NumberOfDescendantsComputer<ValueType>::computeInitialValue(std::vector<AttrType> &attr,
+  template<class ValueType, class IndexType>
+  void NumberOfDescendantsComputer<ValueType, IndexType>::computeInitialValue(std::vector<AttrType> &attr,
     NodePtr node)
   {
     attr[node->id()] += node->children().size();
   }
 
-  template<class ValueType>
-  void NumberOfDescendantsComputer<ValueType>::mergeToParent(std::vector<AttrType> &attr,
+  template<class ValueType, class IndexType>
+  void NumberOfDescendantsComputer<ValueType, IndexType>::mergeToParent(std::vector<AttrType> &attr,
     NodePtr node, NodePtr parent)
   {
     attr[parent->id()] += attr[node->id()];
@@ -4,6 +4,7 @@
 #include "morphotree/attributes/attributeComputer.hpp"
 #include "morphotree/core/box.hpp"
 #include "morphotree/core/point.hpp"
+#include "morphotree/core/paddedImage.hpp"
 #include "morphotree/adjacency/adjacency8c.hpp"
 
 #include <array>
@@ -24,6 +25,10 @@ namespace morphotree
 
     MaxTreePerimeterComputer(Box domain, const std::vector<ValueType> &image);
 
+    // the border of "image" is lower than every pixel, whatever its
+    // sentinel, as the outside of the domain in the constructor above.
+    MaxTreePerimeterComputer(const PaddedImage<ValueType> &image);
+
     std::vector<uint32> initAttributes(const TreeType &tree);
     void computeInitialValue(std::vector<uint32> &attr, NodePtr node);
     void mergeToParent(std::vector<uint32> &attr, NodePtr node, NodePtr parent); 
@@ -36,7 +41,8 @@ namespace morphotree
   private:
     const std::vector<ValueType> &image_;
     Box domain_;
-    
+    const PaddedImage<ValueType> *padded_;
+    std::array<int32, 4> paddedOffsets_;
   };
 
   template<class ValueType>
@@ -49,6 +55,10 @@ namespace morphotree
 
     MinTreePerimeterComputer(Box domain, const std::vector<ValueType> &image);
 
+    // the border of "image" is greater than every pixel, whatever its
+    // sentinel, as the outside of the domain in the constructor above.
+    MinTreePerimeterComputer(const PaddedImage<ValueType> &image);
+
     std::vector<uint32> initAttributes(const TreeType &tree);
     void computeInitialValue(std::vector<uint32> &attr, NodePtr node);
     void mergeToParent(std::vector<uint32> &attr, NodePtr node, NodePtr parent);    
@@ -61,6 +71,8 @@ namespace morphotree
   private:
     const std::vector<ValueType> &image_;
     Box domain_;
+    const PaddedImage<ValueType> *padded_;
+    std::array<int32, 4> paddedOffsets_;
   };
 
 
@@ -69,9 +81,18 @@ namespace morphotree
   template<class ValueType>
   MaxTreePerimeterComputer<ValueType>::MaxTreePerimeterComputer(Box domain,
     const std::vector<ValueType> &image)
-    :domain_{domain}, image_{image}
+    :domain_{domain}, image_{image}, padded_{nullptr}
   {}
 
+  template<class ValueType>
+  MaxTreePerimeterComputer<ValueType>::MaxTreePerimeterComputer(
+    const PaddedImage<ValueType> &image)
+    :domain_{image.domain()}, image_{image.values()}, padded_{&image}
+  {
+    for (uint32 i = 0; i < offsets_.size(); i++)
+      paddedOffsets_[i] = image.offset(offsets_[i]);
+  }
+
   template<class ValueType>
   std::vector<uint32> MaxTreePerimeterComputer<ValueType>::initAttributes(
     const MaxTreePerimeterComputer<ValueType>::TreeType &tree)
@@ -83,6 +104,21 @@ namespace morphotree
   void MaxTreePerimeterComputer<ValueType>::computeInitialValue(std::vector<uint32> &attr,
     MaxTreePerimeterComputer<ValueType>::NodePtr node)
   {    
+    if (padded_ != nullptr) {
+      for (uint32 pidx : node->cnps()) {
+        int32 H = 0, L = 0;
+        uint32 pp = padded_->paddedIndex(pidx);
+        for (int32 offset : paddedOffsets_) {
+          ValueType q = (*padded_)[pp + offset];
+          bool border = padded_->isBorder(pp + offset);
+          L += border || q < node->level();
+          H += !border && q > node->level();
+        }
+        attr[node->id()] += L - H;
+      }
+      return;
+    }
+
     for (uint32 pidx : node->cnps()) {
       int32 H = 0, L = 0;
       I32Point p = domain_.indexToPoint(pidx);
@@ -111,9 +147,18 @@ namespace morphotree
   template<class ValueType>
   MinTreePerimeterComputer<ValueType>::MinTreePerimeterComputer(Box domain,
     const std::vector<ValueType> &image)
-    :domain_{domain}, image_{image}
+    :domain_{domain}, image_{image}, padded_{nullptr}
   {}
 
+  template<class ValueType>
+  MinTreePerimeterComputer<ValueType>::MinTreePerimeterComputer(
+    const PaddedImage<ValueType> &image)
+    :domain_{image.domain()}, image_{image.values()}, padded_{&image}
+  {
+    for (uint32 i = 0; i < offsets_.size(); i++)
+      paddedOffsets_[i] = image.offset(offsets_[i]);
+  }
+
   template<class ValueType>
   std::vector<uint32> MinTreePerimeterComputer<ValueType>::initAttributes(
     const MinTreePerimeterComputer<ValueType>::TreeType &tree)
@@ -125,6 +170,21 @@ namespace morphotree
   void MinTreePerimeterComputer<ValueType>::computeInitialValue(std::vector<uint32> &attr,
     MinTreePerimeterComputer<ValueType>::NodePtr node)
   {
+    if (padded_ != nullptr) {
+      for (uint32 pidx : node->cnps()) {
+        int32 H = 0, L = 0;
+        uint32 pp = padded_->paddedIndex(pidx);
+        for (int32 offset : paddedOffsets_) {
+          ValueType q = (*padded_)[pp + offset];
+          bool border = padded_->isBorder(pp + offset);
+          H += border || q > node->level();
+          L += !border && q < node->level();
+        }
+        attr[node->id()] += H - L;
+      }
+      return;
+    }
+
     for (uint32 pidx : node->cnps()) {
       int32 H = 0, L = 0;
       I32Point p = domain_.indexToPoint(pidx);
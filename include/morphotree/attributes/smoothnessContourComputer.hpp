@@ -4,6 +4,7 @@
 #include "morphotree/attributes/attributeComputer.hpp"
 #include "morphotree/core/box.hpp"
 #include "morphotree/core/point.hpp"
+#include "morphotree/core/paddedImage.hpp"
 
 // Implementation based on 
 // Connected Attribute Filtering Based on Contour Smoothness
@@ -22,6 +23,11 @@ namespace morphotree
 
     MaxTreeSmoothnessContourComputer(Box domain, const std::vector<ValueType> &image);
 
+    // the border of "image" is lower than every pixel, as in
+    // MaxTreePerimeterComputer, which gives the values of the constructor
+    // above.
+    MaxTreeSmoothnessContourComputer(const PaddedImage<ValueType> &image);
+
     std::vector<float> initAttributes(const TreeType &tree);
     void computeInitialValue(std::vector<float> &attr, NodePtr node);
     void mergeToParent(std::vector<float> &attr, NodePtr node, NodePtr parent);
@@ -31,6 +37,8 @@ namespace morphotree
   private:
     Box domain_;
     const std::vector<ValueType> &image_; 
+    const PaddedImage<ValueType> *padded_;
+    std::array<int32, 4> paddedOffsets_;
 
     std::vector<uint32> area_;
     std::vector<uint32> perimeter_;
@@ -55,6 +63,11 @@ namespace morphotree
 
     MinTreeSmoothnessContourComputer(Box domain, const std::vector<ValueType> &image);
 
+    // the border of "image" is greater than every pixel, as in
+    // MinTreePerimeterComputer, which gives the values of the constructor
+    // above.
+    MinTreeSmoothnessContourComputer(const PaddedImage<ValueType> &image);
+
     std::vector<float> initAttributes(const TreeType &tree);
     void computeInitialValue(std::vector<float> &attr, NodePtr node);
     void mergeToParent(std::vector<float> &attr, NodePtr node, NodePtr parent);
@@ -64,6 +77,8 @@ namespace morphotree
   private:
     Box domain_;
     const std::vector<ValueType> &image_;
+    const PaddedImage<ValueType> *padded_;
+    std::array<int32, 4> paddedOffsets_;
 
     std::vector<uint32> area_;
     std::vector<uint32> perimeter_;
@@ -121,9 +136,18 @@ namespace morphotree
   template<class ValueType>
   MaxTreeSmoothnessContourComputer<ValueType>::MaxTreeSmoothnessContourComputer(Box domain, 
     const std::vector<ValueType> &image)
-    :domain_{domain}, image_{image}
+    :domain_{domain}, image_{image}, padded_{nullptr}
   {}
 
+  template<class ValueType>
+  MaxTreeSmoothnessContourComputer<ValueType>::MaxTreeSmoothnessContourComputer(
+    const PaddedImage<ValueType> &image)
+    :domain_{image.domain()}, image_{image.values()}, padded_{&image}
+  {
+    for (uint32 i = 0; i < offsets_.size(); i++)
+      paddedOffsets_[i] = image.offset(offsets_[i]);
+  }
+
   template<class ValueType>
   std::vector<float> MaxTreeSmoothnessContourComputer<ValueType>::initAttributes(
     const TreeType &tree)
@@ -151,13 +175,24 @@ namespace morphotree
     for (uint32 pidx : node->cnps()) {
       int32 H = 0, L = 0;
       I32Point p = domain_.indexToPoint(pidx);
-      for (const I32Point &offset : offsets_) {
-        I32Point q = p + offset;
-        if (!domain_.contains(q) || image_[domain_.pointToIndex(q)] < node->level()) {
-          L++;
+      if (padded_ != nullptr) {
+        uint32 pp = padded_->paddedIndex(pidx);
+        for (int32 offset : paddedOffsets_) {
+          ValueType q = (*padded_)[pp + offset];
+          bool border = padded_->isBorder(pp + offset);
+          L += border || q < node->level();
+          H += !border && q > node->level();
         }
-        else if (image_[domain_.pointToIndex(q)] > node->level()) {
-          H++;
+      }
+      else {
+        for (const I32Point &offset : offsets_) {
+          I32Point q = p + offset;
+          if (!domain_.contains(q) || image_[domain_.pointToIndex(q)] < node->level()) {
+            L++;
+          }
+          else if (image_[domain_.pointToIndex(q)] > node->level()) {
+            H++;
+          }
         }
       }
       perimeter_[node->id()] += L - H;
@@ -197,9 +232,18 @@ namespace morphotree
   template<class ValueType>
   MinTreeSmoothnessContourComputer<ValueType>::MinTreeSmoothnessContourComputer(Box domain, 
     const std::vector<ValueType> &image)
-    :domain_{domain}, image_{image}
+    :domain_{domain}, image_{image}, padded_{nullptr}
   {}
 
+  template<class ValueType>
+  MinTreeSmoothnessContourComputer<ValueType>::MinTreeSmoothnessContourComputer(
+    const PaddedImage<ValueType> &image)
+    :domain_{image.domain()}, image_{image.values()}, padded_{&image}
+  {
+    for (uint32 i = 0; i < offsets_.size(); i++)
+      paddedOffsets_[i] = image.offset(offsets_[i]);
+  }
+
   template<class ValueType>
   std::vector<float> MinTreeSmoothnessContourComputer<ValueType>::initAttributes(
     const TreeType &tree)
@@ -227,13 +271,24 @@ namespace morphotree
     for (uint32 pidx : node->cnps()) {
       int32 H = 0, L = 0;
       I32Point p = domain_.indexToPoint(pidx);
-      for (const I32Point &offset : offsets_) {
-        I32Point q = p + offset;
-        if (!domain_.contains(q) || image_[domain_.pointToIndex(q)] > node->level()) {
-          H++;
+      if (padded_ != nullptr) {
+        uint32 pp = padded_->paddedIndex(pidx);
+        for (int32 offset : paddedOffsets_) {
+          ValueType q = (*padded_)[pp + offset];
+          bool border = padded_->isBorder(pp + offset);
+          H += border || q > node->level();
+          L += !border && q < node->level();
         }
-        else if (image_[domain_.pointToIndex(q)] < node->level()) {
-          L++;
+      }
+      else {
+        for (const I32Point &offset : offsets_) {
+          I32Point q = p + offset;
+          if (!domain_.contains(q) || image_[domain_.pointToIndex(q)] > node->level()) {
+            H++;
+          }
+          else if (image_[domain_.pointToIndex(q)] < node->level()) {
+            L++;
+          }
         }
       }
       perimeter_[node->id()] += H - L;
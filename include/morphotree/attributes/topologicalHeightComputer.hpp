@@ -5,12 +5,12 @@
 
 namespace morphotree
 {
-  template<class ValueType>
-  class TopologicalHeightComputer : public AttributeComputer<uint32, ValueType>
+  template<class ValueType, class IndexType = uint32>
+  class TopologicalHeightComputer : public AttributeComputer<uint32, ValueType, IndexType>
   {
   public:
     using AttrType = uint32;
-    using TreeType = typename AttributeComputer<uint32, ValueType>::TreeType;
+    using TreeType = typename AttributeComputer<uint32, ValueType, IndexType>::TreeType;
     using NodePtr = typename TreeType::NodePtr;
 
     std::vector<AttrType> initAttributes(const TreeType &tree);
@@ -19,20 +19,20 @@ namespace morphotree
   };
 
   // ========================== [ IMPLEMENTATION ] ==============================================
-  template<class ValueType>
-  std::vector<typename TopologicalHeightComputer<ValueType>::AttrType> 
-    TopologicalHeightComputer<ValueType>::initAttributes(const TreeType &tree)
+  template<class ValueType, class IndexType>
+  std::vector<typename TopologicalHeightComputer<ValueType, IndexType>::AttrType> 
+    TopologicalHeightComputer<ValueType, IndexType>::initAttributes(const TreeType &tree)
   {
     return std::vector<AttrType>(tree.numberOfNodes(), 0);
   }
 
-  template<class ValueType>
-  void TopologicalHeightComputer<ValueType>::computeInitialValue(std::vector<AttrType> &attr,
+  template<class ValueType, class IndexType>
+  void TopologicalHeightComputer<ValueType, IndexType>::computeInitialValue(std::vector<AttrType> &attr,
     NodePtr node)
   {}
 
-  template<class ValueType>
-  void TopologicalHeightComputer<ValueType>::mergeToParent(std::vector<AttrType> &attr, 
+  template<class ValueType, class IndexType>
+  void TopologicalHeightComputer<ValueType, IndexType>::mergeToParent(std::vector<AttrType> &attr, 
     NodePtr node, NodePtr parent)
   {        
     if (attr[parent->id()] > 0) {
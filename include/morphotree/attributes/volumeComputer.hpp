@@ -7,12 +7,12 @@
 
 namespace morphotree
 {
-  template<class ValueType>
-  class VolumeComputer : public AttributeComputer<float, ValueType>
+  template<class ValueType, class IndexType = uint32>
+  class VolumeComputer : public AttributeComputer<float, ValueType, IndexType>
   {
   public:
     using AttrType = float;
-    using TreeType = typename AttributeComputer<float, ValueType>::TreeType;
+    using TreeType = typename AttributeComputer<float, ValueType, IndexType>::TreeType;
     using NodePtr = typename TreeType::NodePtr;
 
     std::vector<float> initAttributes(const TreeType &tree);
@@ -24,22 +24,22 @@ namespace morphotree
   };
 
   // ================ [Implementation] ======================================================
-  template<class ValueType>
-  std::vector<float> VolumeComputer<ValueType>::initAttributes(const TreeType &tree)
+  template<class ValueType, class IndexType>
+  std::vector<float> VolumeComputer<ValueType, IndexType>::initAttributes(const TreeType &tree)
   {
     area_.resize(tree.numberOfNodes(), 0);
     return std::vector<float>(tree.numberOfNodes(), 0.f);   
   }
 
-  template<class ValueType>
-  void VolumeComputer<ValueType>::computeInitialValue(std::vector<float> &attr, NodePtr node)
+  template<class ValueType, class IndexType>
+  void VolumeComputer<ValueType, IndexType>::computeInitialValue(std::vector<float> &attr, NodePtr node)
   {
     area_[node->id()] += node->cnps().size();
     attr[node->id()] += node->cnps().size();
   }
 
-  template<class ValueType>
-  void VolumeComputer<ValueType>::mergeToParent(std::vector<float> &attr, NodePtr node, 
+  template<class ValueType, class IndexType>
+  void VolumeComputer<ValueType, IndexType>::mergeToParent(std::vector<float> &attr, NodePtr node, 
     NodePtr parent)
   {
     area_[parent->id()] += area_[node->id()];
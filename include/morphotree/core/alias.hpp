@@ -5,6 +5,7 @@ namespace morphotree
   using uint8 = unsigned char;
   using uint16 = unsigned short;
   using uint32 = unsigned int;
+  using uint64 = unsigned long long;
   using int8 = char;
   using int16 = short;
   using int32 = int;
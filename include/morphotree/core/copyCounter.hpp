@@ -0,0 +1,30 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+
+#include <atomic>
+
+namespace morphotree
+{
+  // CopyCounter counts the copies of the results which carry whole-image
+  // arrays through the build pipeline (CTBuilderResult, OrderImageResult
+  // and MorphologicalTree), so that a copy slipping into a pipeline meant
+  // to move its buffers shows up in tests. It only counts in debug builds
+  // (NDEBUG not defined); in release builds increment() does nothing.
+  class CopyCounter
+  {
+  public:
+    static uint64 count();
+    static void reset();
+
+    static inline void increment()
+    {
+    #ifndef NDEBUG
+      counter().fetch_add(1, std::memory_order_relaxed);
+    #endif
+    }
+
+  private:
+    static std::atomic<uint64>& counter();
+  };
+}
\ No newline at end of file
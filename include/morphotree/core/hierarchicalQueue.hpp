@@ -0,0 +1,79 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+
+#include <vector>
+
+namespace morphotree
+{
+  // Hierarchical queue of element indices with integer levels in
+  // [0, numberOfLevels): pop() returns an element of the highest non-empty
+  // level (the last one pushed at that level). The capacity of every level
+  // is given at construction and the storage is a single array. The
+  // non-empty levels are tracked by a two-level bitmap, so the next level
+  // is found in a few word scans even with 65536 levels.
+  class HierarchicalQueue
+  {
+  public:
+    HierarchicalQueue();
+    HierarchicalQueue(const std::vector<uint32> &levelCapacity);
+
+    // empties the queue for new capacities, reusing the storage.
+    void reset(const std::vector<uint32> &levelCapacity);
+
+    inline bool empty() const { return size_ == 0; }
+    inline uint32 size() const { return size_; }
+    inline uint32 numberOfLevels() const { return begin_.size(); }
+
+    // highest non-empty level. The queue must not be empty.
+    inline uint32 topLevel() const { return top_; }
+
+    inline void push(uint32 level, uint32 v);
+    inline uint32 pop();
+
+  private:
+    inline static uint32 highestBit(uint64 word);
+    void updateTopLevel();
+
+  private:
+    std::vector<uint32> begin_;
+    std::vector<uint32> end_;
+    std::vector<uint32> data_;
+    std::vector<uint64> levelBits_;
+    std::vector<uint64> wordBits_;
+    uint32 top_;
+    uint32 size_;
+  };
+
+  // ===================== [ IMPLEMENTATION ] ==================================
+  void HierarchicalQueue::push(uint32 level, uint32 v)
+  {
+    data_[end_[level]++] = v;
+    levelBits_[level >> 6] |= uint64(1) << (level & 63);
+    wordBits_[level >> 12] |= uint64(1) << ((level >> 6) & 63);
+    if (size_ == 0 || level > top_)
+      top_ = level;
+    size_++;
+  }
+
+  uint32 HierarchicalQueue::pop()
+  {
+    uint32 v = data_[--end_[top_]];
+    size_--;
+    if (end_[top_] == begin_[top_])
+      updateTopLevel();
+    return v;
+  }
+
+  uint32 HierarchicalQueue::highestBit(uint64 word)
+  {
+  #if defined(__GNUC__)
+    return 63 - __builtin_clzll(word);
+  #else
+    uint32 b = 0;
+    while (word >>= 1)
+      b++;
+    return b;
+  #endif
+  }
+}
\ No newline at end of file
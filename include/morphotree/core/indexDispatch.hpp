@@ -0,0 +1,35 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+namespace morphotree
+{
+  // tag of an index type, given to the functions called by
+  // withNarrowestIndex.
+  template<class IndexType>
+  struct IndexTag
+  {
+    using Type = IndexType;
+  };
+
+  // Calls "fn" with the IndexTag of the narrower of uint16 and uint32
+  // which holds "numberOfElements" (the largest value of the type is left
+  // to mark undefined indices), so that a structure templated on the index
+  // type is instantiated with the smallest storage. "fn" must return the
+  // same type for both index types. The boxes, adjacencies and sorts
+  // address pixels as uint32, so larger images cannot be built in memory:
+  // they throw, and are built tile by tile by TiledTreeBuilder.
+  template<class Function>
+  auto withNarrowestIndex(uint64 numberOfElements, Function &&fn) -> decltype(fn(IndexTag<uint32>{}))
+  {
+    if (numberOfElements <= std::numeric_limits<uint16>::max())
+      return fn(IndexTag<uint16>{});
+    if (numberOfElements <= std::numeric_limits<uint32>::max())
+      return fn(IndexTag<uint32>{});
+    throw std::runtime_error("too many elements for an in-memory tree (more than uint32 holds); "
+      "build it tile by tile with TiledTreeBuilder");
+  }
+}
\ No newline at end of file
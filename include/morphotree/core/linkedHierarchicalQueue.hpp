@@ -0,0 +1,57 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+#include "morphotree/core/hqueue.hpp"
+
+#include <vector>
+
+namespace morphotree
+{
+  // Hierarchical FIFO queue of element indices in [0, numberOfElements)
+  // with levels in [0, numberOfLevels). pop(level) follows HQueue<uint8>:
+  // it removes the first element of the non-empty level closest to "level",
+  // the lower one on ties. An element is in the queue at most once, so the
+  // queue of every level is a linked list through a single array: once
+  // reset, the queue never allocates, and reset() with the same sizes
+  // reuses the storage.
+  class LinkedHierarchicalQueue
+  {
+  public:
+    using KeyValueType = KeyValue<uint32, uint32>;
+
+    LinkedHierarchicalQueue();
+    LinkedHierarchicalQueue(uint32 numberOfLevels, uint32 numberOfElements);
+
+    // empties the queue for the given sizes.
+    void reset(uint32 numberOfLevels, uint32 numberOfElements);
+
+    inline bool isEmpty() const { return size_ == 0; }
+    inline uint32 size() const { return size_; }
+
+    inline void insert(uint32 level, uint32 v);
+    KeyValueType pop(uint32 level);
+
+  private:
+    bool findClosestNonEmptyLevel(uint32 level, uint32 &found) const;
+
+  private:
+    static const uint32 Empty;
+
+    std::vector<uint32> head_;
+    std::vector<uint32> tail_;
+    std::vector<uint32> next_;
+    uint32 size_;
+  };
+
+  // ===================== [ IMPLEMENTATION ] ==================================
+  void LinkedHierarchicalQueue::insert(uint32 level, uint32 v)
+  {
+    next_[v] = Empty;
+    if (head_[level] == Empty)
+      head_[level] = v;
+    else
+      next_[tail_[level]] = v;
+    tail_[level] = v;
+    size_++;
+  }
+}
\ No newline at end of file
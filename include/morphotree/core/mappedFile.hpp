@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace morphotree
+{
+  // Read-only memory mapping of a whole file. Where mmap is not available
+  // (or fails) the file is read into memory instead.
+  class MappedFile
+  {
+  public:
+    MappedFile();
+    MappedFile(const std::string &filename);
+    MappedFile(MappedFile &&other);
+    MappedFile& operator=(MappedFile &&other);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &other) = delete;
+    MappedFile& operator=(const MappedFile &other) = delete;
+
+    void open(const std::string &filename);
+    void close();
+
+    inline bool isOpen() const { return data_ != nullptr; }
+    inline bool isMapped() const { return mapped_; }
+    inline const char* data() const { return data_; }
+    inline std::size_t size() const { return size_; }
+
+  private:
+    const char *data_;
+    std::size_t size_;
+    bool mapped_;
+    std::vector<char> buffer_;
+  };
+}
\ No newline at end of file
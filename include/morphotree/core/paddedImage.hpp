@@ -0,0 +1,97 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+#include "morphotree/core/box.hpp"
+#include "morphotree/core/point.hpp"
+
+#include <vector>
+
+namespace morphotree
+{
+  // PaddedImage stores an image of "domain" with one element of border all
+  // around it, set to "sentinel". The elements are addressed by "padded
+  // indices" in a (width+2) x (height+2) raster, so every pixel of the
+  // domain has all of its 8 neighbours in the buffer and a neighbour is a
+  // fixed linear offset away: loops over the pixels need neither bounds
+  // checks nor coordinate conversions. The border is also marked in a
+  // mask, so that algorithms can tell it apart from pixels whose value
+  // equals "sentinel" (e.g. 0 in an 8-bit image).
+  template<class ValueType>
+  class PaddedImage
+  {
+  public:
+    PaddedImage(const Box &domain, const std::vector<ValueType> &f, ValueType sentinel);
+
+    inline const Box& domain() const { return domain_; }
+    inline ValueType sentinel() const { return sentinel_; }
+    inline uint32 stride() const { return stride_; }
+    inline uint32 size() const { return data_.size(); }
+
+    // padded buffer, border included.
+    inline const std::vector<ValueType>& values() const { return data_; }
+    inline ValueType operator[](uint32 pp) const { return data_[pp]; }
+
+    // whether the padded index "pp" is an element of the border.
+    inline bool isBorder(uint32 pp) const { return border_[pp] != 0; }
+
+    // value of the pixel of index "p" of the domain.
+    inline ValueType at(uint32 p) const { return data_[paddedIndex(p)]; }
+
+    inline uint32 paddedIndex(uint32 p) const;
+    inline uint32 imageIndex(uint32 pp) const;
+    inline int32 offset(const I32Point &d) const { return d.y() * int32(stride_) + d.x(); }
+
+    // copies "f" into the pixels of the domain, keeping the border.
+    void assign(const std::vector<ValueType> &f);
+
+  private:
+    Box domain_;
+    ValueType sentinel_;
+    uint32 width_;
+    uint32 stride_;
+    std::vector<ValueType> data_;
+    std::vector<uint8> border_;
+  };
+
+  // ===================== [ IMPLEMENTATION ] ==================================
+  template<class ValueType>
+  PaddedImage<ValueType>::PaddedImage(const Box &domain, const std::vector<ValueType> &f,
+    ValueType sentinel)
+    :domain_{domain}, sentinel_{sentinel}, width_{domain.width()},
+     stride_{domain.width() + 2},
+     data_((domain.width() + 2) * (domain.height() + 2), sentinel),
+     border_(data_.size(), 1)
+  {
+    const uint32 height = domain_.height();
+    for (uint32 y = 0; y < height; y++) {
+      uint8 *prow = border_.data() + (y + 1) * stride_ + 1;
+      for (uint32 x = 0; x < width_; x++)
+        prow[x] = 0;
+    }
+    assign(f);
+  }
+
+  template<class ValueType>
+  uint32 PaddedImage<ValueType>::paddedIndex(uint32 p) const
+  {
+    return p + 2 * (p / width_) + stride_ + 1;
+  }
+
+  template<class ValueType>
+  uint32 PaddedImage<ValueType>::imageIndex(uint32 pp) const
+  {
+    return (pp / stride_ - 1) * width_ + (pp % stride_ - 1);
+  }
+
+  template<class ValueType>
+  void PaddedImage<ValueType>::assign(const std::vector<ValueType> &f)
+  {
+    const uint32 height = domain_.height();
+    for (uint32 y = 0; y < height; y++) {
+      const ValueType *row = f.data() + y * width_;
+      ValueType *prow = data_.data() + (y + 1) * stride_ + 1;
+      for (uint32 x = 0; x < width_; x++)
+        prow[x] = row[x];
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+#include "morphotree/core/box.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace morphotree
+{
+  // RasterFile reads windows of a raster image stored on disk without
+  // loading the whole image: only the rows of the window are read. The
+  // file is either raw (row-major samples in the native byte order,
+  // starting at a given offset) or a binary PGM (P5) or PPM (P6) image,
+  // whose 16-bit samples are big-endian. The pixels of a PPM image are
+  // read as their luma 0.299 R + 0.587 G + 0.114 B.
+  class RasterFile
+  {
+  public:
+    enum class Format { Raw, PGM, PPM };
+
+    // raw image of "width" x "height" samples of "bytesPerSample" bytes.
+    static RasterFile openRaw(const std::string &filename, uint32 width, uint32 height,
+      uint32 bytesPerSample, std::uint64_t offset = 0);
+
+    // PGM or PPM image, according to its magic number.
+    static RasterFile openPNM(const std::string &filename);
+
+    RasterFile(RasterFile &&other) = default;
+    RasterFile& operator=(RasterFile &&other) = default;
+
+    inline Format format() const { return format_; }
+    inline uint32 width() const { return width_; }
+    inline uint32 height() const { return height_; }
+    inline uint32 channels() const { return channels_; }
+    inline uint32 bytesPerSample() const { return bytesPerSample_; }
+    inline Box domain() const { return Box::fromSize(UI32Point{width_, height_}); }
+
+    // reads the pixels of "window" (a box of domain()) into "f", row by
+    // row. The samples of a raw image are read as ValueType, which must
+    // have "bytesPerSample" bytes; those of a PNM image are converted.
+    template<class ValueType>
+    void read(const Box &window, std::vector<ValueType> &f);
+
+  private:
+    RasterFile(const std::string &filename, Format format, uint32 width, uint32 height,
+      uint32 channels, uint32 bytesPerSample, std::uint64_t offset);
+
+    // reads the bytes of the "count" pixels of row "y" from column "x" on.
+    const char* readRow(uint32 x, uint32 y, uint32 count);
+    void checkWindow(const Box &window) const;
+    double pnmValue(const char *pixel) const;
+
+  private:
+    std::ifstream in_;
+    std::string filename_;
+    Format format_;
+    uint32 width_;
+    uint32 height_;
+    uint32 channels_;
+    uint32 bytesPerSample_;
+    std::uint64_t offset_;
+    std::vector<char> row_;
+  };
+
+  // ===================== [ IMPLEMENTATION ] ==================================
+  template<class ValueType>
+  void RasterFile::read(const Box &window, std::vector<ValueType> &f)
+  {
+    checkWindow(window);
+    if (format_ == Format::Raw && sizeof(ValueType) != bytesPerSample_)
+      throw std::runtime_error("the samples of " + filename_ + " do not have the size of the value type");
+
+    const uint32 w = window.width();
+    f.resize(std::size_t(w) * window.height());
+    for (uint32 y = 0; y < window.height(); y++) {
+      const char *row = readRow(window.left(), window.top() + y, w);
+      ValueType *out = f.data() + std::size_t(y) * w;
+      if (format_ == Format::Raw) {
+        std::memcpy(out, row, std::size_t(w) * sizeof(ValueType));
+        continue;
+      }
+
+      const uint32 pixelBytes = channels_ * bytesPerSample_;
+      for (uint32 x = 0; x < w; x++) {
+        double v = pnmValue(row + std::size_t(x) * pixelBytes);
+        out[x] = std::is_integral<ValueType>::value ? static_cast<ValueType>(v + 0.5)
+                                                     : static_cast<ValueType>(v);
+      }
+    }
+  }
+}
\ No newline at end of file
@@ -7,6 +7,10 @@
 #include <algorithm>
 #include <numeric>
 #include <functional>
+#include <type_traits>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
 
 namespace morphotree
 {
@@ -14,17 +18,115 @@ namespace morphotree
   std::vector<uint32> STLsortIndex(const std::vector<T> &v, 
     std::function<bool(const T&, const T&)> cmp);
 
+  // The sorts below return the indices of "v" ordered by value, decreasing
+  // for the "Increasing" ones (the order of the max-tree construction) and
+  // increasing for the "Decreasing" ones; equal values keep the increasing
+  // order of their indices. T must be an arithmetic type.
+  // With "numberOfThreads" > 1, every counting pass is split between the
+  // threads, with the same result.
   template<typename T>
-  std::vector<uint32> countingSortIncreasing(const std::vector<T> &v);
+  std::vector<uint32> countingSortIncreasing(const std::vector<T> &v, uint32 numberOfThreads = 1);
 
   template <typename T>
-  std::vector<uint32> countingSortDecreasing(const std::vector<T> &v);
+  std::vector<uint32> countingSortDecreasing(const std::vector<T> &v, uint32 numberOfThreads = 1);
+
+  template<typename T>
+  std::vector<uint32> radixSortIncreasing(const std::vector<T> &v, uint32 numberOfThreads = 1);
+
+  template<typename T>
+  std::vector<uint32> radixSortDecreasing(const std::vector<T> &v, uint32 numberOfThreads = 1);
     
   template<typename T>
-  std::vector<uint32> sortIncreasing(const std::vector<T> &v);
+  std::vector<uint32> sortIncreasing(const std::vector<T> &v, uint32 numberOfThreads = 1);
+
+  template<typename T>
+  std::vector<uint32> sortDecreasing(const std::vector<T> &v, uint32 numberOfThreads = 1);
+
+  // turns, in place, the order of sortIncreasing(v) into the one of
+  // sortDecreasing(v) and vice versa: the runs of equal values are reversed
+  // as a whole, keeping the order of the indices within each run.
+  template<typename T>
+  void reverseLevelOrder(const std::vector<T> &v, std::vector<uint32> &R);
+
+  // order-preserving map of the values of T to the unsigned integers of
+  // the same size, used as keys by the radix sort.
+  template<typename T, class Enable = void>
+  struct RadixKey;
+
+  template<typename T>
+  struct RadixKey<T, typename std::enable_if<std::is_integral<T>::value>::type>
+  {
+    using Type = typename std::conditional<sizeof(T) == 1, uint8,
+      typename std::conditional<sizeof(T) == 2, uint16,
+      typename std::conditional<sizeof(T) == 4, uint32, uint64>::type>::type>::type;
+
+    static inline Type key(T v)
+    {
+      // the sign bit is flipped, so negative values come first.
+      const Type sign = std::is_signed<T>::value ? Type(Type(1) << (8 * sizeof(Type) - 1)) : Type(0);
+      return Type(static_cast<Type>(v) ^ sign);
+    }
+  };
+
+  template<typename T>
+  struct RadixKey<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+  {
+    using Type = typename std::conditional<sizeof(T) == 4, uint32, uint64>::type;
+
+    static inline Type key(T v)
+    {
+      // IEEE 754: positive values get the sign bit set, negative ones are
+      // complemented so that greater magnitudes come first. -0 is taken as 0.
+      const Type sign = Type(1) << (8 * sizeof(Type) - 1);
+      Type bits;
+      if (v == T(0))
+        v = T(0);
+      std::memcpy(&bits, &v, sizeof(Type));
+      return (bits & sign) ? Type(~bits) : Type(bits | sign);
+    }
+  };
+
+  // RadixSorter keeps the buffers of the radix sort between calls, so
+  // that sorting inputs of the same size again does not allocate. The
+  // orders are those of sortIncreasing and sortDecreasing, written as
+  // IndexType (the index type of the tree to build).
+  template<typename T, class IndexType = uint32>
+  class RadixSorter
+  {
+  public:
+    void sortIncreasing(const std::vector<T> &v, std::vector<IndexType> &idx,
+      uint32 numberOfThreads = 1);
+    void sortDecreasing(const std::vector<T> &v, std::vector<IndexType> &idx,
+      uint32 numberOfThreads = 1);
+
+    void sort(const std::vector<T> &v, bool decreasingValues, std::vector<IndexType> &idx,
+      uint32 numberOfThreads);
+
+  private:
+    using Key = typename RadixKey<T>::Type;
+
+    std::vector<Key> key_;
+    std::vector<Key> nextKey_;
+    std::vector<IndexType> nextIdx_;
+    std::vector<uint32> chunkBegin_;
+    std::vector<uint32> counter_;
+  };
 
   template<typename T>
-  std::vector<uint32> sortDecreasing(const std::vector<T> &v);
+  std::vector<uint32> radixSortIndex(const std::vector<T> &v, bool decreasingValues,
+    uint32 numberOfThreads);
+
+  // stable counting scatter of the elements 0, ..., numberOfElements-1 by
+  // digit(i) in [0, numberOfBuckets): calls move(i, position of i). Returns
+  // false, without moving anything, if all of the elements have the same
+  // digit. "chunkBegin" and "counter" are scratch buffers.
+  template<class DigitFunc, class MoveFunc>
+  bool countingScatter(uint32 numberOfElements, uint32 numberOfBuckets,
+    uint32 numberOfThreads, DigitFunc digit, MoveFunc move,
+    std::vector<uint32> &chunkBegin, std::vector<uint32> &counter);
+
+  // smallest share of the elements given to a thread by countingScatter.
+  const uint32 MinElementsPerSortThread = 1 << 16;
 
 
   // ===========[ IMPLEMENTATION ] ============================================
@@ -40,60 +142,173 @@ namespace morphotree
     return idx;
   }
 
-  template<typename T>
-  std::vector<uint32> countingSortIncreasing(const std::vector<T> &v)
+  template<class DigitFunc, class MoveFunc>
+  bool countingScatter(uint32 numberOfElements, uint32 numberOfBuckets,
+    uint32 numberOfThreads, DigitFunc digit, MoveFunc move,
+    std::vector<uint32> &chunkBegin, std::vector<uint32> &counter)
   {
-    T maxvalue = std::numeric_limits<T>::max();
-    std::vector<uint32> counter(maxvalue + 1, 0);
-    std::vector<uint32> idx(v.size());
+    // each thread counts the digits of a contiguous chunk of the elements;
+    // the positions of a digit are handed out to the chunks in order, so
+    // the scatter is stable whatever the number of threads.
+    const int numberOfChunks = static_cast<int>(std::max<uint32>(1,
+      std::min(numberOfThreads, numberOfElements / MinElementsPerSortThread)));
+    std::vector<uint32> &begin = chunkBegin;
+    begin.resize(numberOfChunks + 1);
+    for (int c = 0; c <= numberOfChunks; c++)
+      begin[c] = static_cast<uint32>((static_cast<uint64>(numberOfElements) * c) / numberOfChunks);
 
-    for (uint32 i = 0; i < v.size(); i++)
-      counter[maxvalue - v[i]]++;
+    counter.assign(numberOfChunks * numberOfBuckets, 0);
+    #pragma omp parallel for num_threads(numberOfChunks)
+    for (int c = 0; c < numberOfChunks; c++) {
+      uint32 *count = counter.data() + c * numberOfBuckets;
+      for (uint32 i = begin[c]; i < begin[c+1]; i++)
+        count[digit(i)]++;
+    }
 
-    for (T i = 1; i < maxvalue; i++) 
-      counter[i] += counter[i - 1];
-    counter[maxvalue] += counter[maxvalue-1];
+    uint32 next = 0;
+    for (uint32 d = 0; d < numberOfBuckets; d++) {
+      const uint32 first = next;
+      for (int c = 0; c < numberOfChunks; c++) {
+        uint32 count = counter[c * numberOfBuckets + d];
+        counter[c * numberOfBuckets + d] = next;
+        next += count;
+      }
+      // a digit shared by all of the elements leaves the order unchanged.
+      if (next - first == numberOfElements)
+        return false;
+    }
 
+    #pragma omp parallel for num_threads(numberOfChunks)
+    for (int c = 0; c < numberOfChunks; c++) {
+      uint32 *offset = counter.data() + c * numberOfBuckets;
+      for (uint32 i = begin[c]; i < begin[c+1]; i++)
+        move(i, offset[digit(i)]++);
+    }
+    return true;
+  }
 
-    for (int i = v.size() - 1; i >= 0; --i)
-      idx[--counter[maxvalue - v[i]]] = i;
+  template<typename T, class IndexType>
+  void RadixSorter<T, IndexType>::sortIncreasing(const std::vector<T> &v,
+    std::vector<IndexType> &idx, uint32 numberOfThreads)
+  {
+    sort(v, true, idx, numberOfThreads);
+  }
 
-    return idx;    
+  template<typename T, class IndexType>
+  void RadixSorter<T, IndexType>::sortDecreasing(const std::vector<T> &v,
+    std::vector<IndexType> &idx, uint32 numberOfThreads)
+  {
+    sort(v, false, idx, numberOfThreads);
   }
 
-  template<typename T>            
-  std::vector<uint32> countingSortDecreasing(const std::vector<T> &v)
+  template<typename T, class IndexType>
+  void RadixSorter<T, IndexType>::sort(const std::vector<T> &v, bool decreasingValues,
+    std::vector<IndexType> &idx, uint32 numberOfThreads)
   {
-    T maxvalue = std::numeric_limits<T>::max();
-    std::vector<uint32> counter(maxvalue+1, 0);
-    std::vector<uint32> idx(v.size());
+    if (v.size() > std::numeric_limits<IndexType>::max() ||
+        v.size() > std::numeric_limits<uint32>::max())
+      throw std::runtime_error("too many elements for the index type of RadixSorter");
 
-    for (uint32 i = 0; i < v.size(); i++)
-      counter[v[i]]++;
+    // LSD radix sort of the keys of "v". Keys of up to 16 bits are sorted
+    // by a single counting pass; wider ones by digits of 11 bits.
+    const uint32 keyBits = 8 * sizeof(Key);
+    const uint32 digitBits = keyBits <= 16 ? keyBits : 11;
+    const uint32 numberOfBuckets = uint32(1) << digitBits;
+    const uint32 mask = numberOfBuckets - 1;
+    const Key flip = decreasingValues ? Key(~Key(0)) : Key(0);
+    const uint32 numberOfElements = v.size();
 
-    for (T i = 1; i < maxvalue; i++) 
-      counter[i] += counter[i-1];
-    counter[maxvalue] += counter[maxvalue-1];
+    idx.resize(numberOfElements);
+    if (keyBits == digitBits) {
+      bool moved = countingScatter(numberOfElements, numberOfBuckets, numberOfThreads,
+        [&v, flip](uint32 i) { return uint32(Key(RadixKey<T>::key(v[i]) ^ flip)); },
+        [&idx](uint32 i, uint32 pos) { idx[pos] = static_cast<IndexType>(i); },
+        chunkBegin_, counter_);
+      if (!moved)
+        std::iota(idx.begin(), idx.end(), IndexType(0));
+      return;
+    }
 
-    for (int i = v.size()-1; i >= 0; i--)
-      idx[--counter[v[i]]] = i;
+    std::vector<Key> &key = key_;
+    key.resize(numberOfElements);
+    const int n = static_cast<int>(numberOfElements);
+    #pragma omp parallel for num_threads(std::max<uint32>(numberOfThreads, 1))
+    for (int i = 0; i < n; i++) {
+      key[i] = Key(RadixKey<T>::key(v[i]) ^ flip);
+      idx[i] = static_cast<IndexType>(i);
+    }
 
+    // the buffers are swapped after every pass that moves the elements, so
+    // "idx" may end up holding the storage of "nextIdx_".
+    nextIdx_.resize(numberOfElements);
+    nextKey_.resize(numberOfElements);
+    for (uint32 shift = 0; shift < keyBits; shift += digitBits) {
+      bool moved = countingScatter(numberOfElements, numberOfBuckets, numberOfThreads,
+        [&key, shift, mask](uint32 i) { return uint32((key[i] >> shift) & mask); },
+        [&](uint32 i, uint32 pos) { nextIdx_[pos] = idx[i]; nextKey_[pos] = key[i]; },
+        chunkBegin_, counter_);
+      if (moved) {
+        idx.swap(nextIdx_);
+        key.swap(nextKey_);
+      }
+    }
+  }
+
+  template<typename T>
+  std::vector<uint32> radixSortIndex(const std::vector<T> &v, bool decreasingValues,
+    uint32 numberOfThreads)
+  {
+    std::vector<uint32> idx;
+    RadixSorter<T>().sort(v, decreasingValues, idx, numberOfThreads);
     return idx;
   }
 
   template<typename T>
-  std::vector<uint32> sortIncreasing(const std::vector<T> &v)
+  std::vector<uint32> radixSortIncreasing(const std::vector<T> &v, uint32 numberOfThreads)
+  {
+    return radixSortIndex(v, true, numberOfThreads);
+  }
+
+  template<typename T>
+  std::vector<uint32> radixSortDecreasing(const std::vector<T> &v, uint32 numberOfThreads)
+  {
+    return radixSortIndex(v, false, numberOfThreads);
+  }
+
+  template<typename T>
+  std::vector<uint32> countingSortIncreasing(const std::vector<T> &v, uint32 numberOfThreads)
+  {
+    // a single counting pass for the types of up to 16 bits. Wider types
+    // would need 2^32 counters or more and are counted digit by digit.
+    return radixSortIndex(v, true, numberOfThreads);
+  }
+
+  template<typename T>            
+  std::vector<uint32> countingSortDecreasing(const std::vector<T> &v, uint32 numberOfThreads)
+  {
+    return radixSortIndex(v, false, numberOfThreads);
+  }
+
+  template<typename T>
+  std::vector<uint32> sortIncreasing(const std::vector<T> &v, uint32 numberOfThreads)
+  {
+    // isLowSizeType types take a single counting pass.
+    return radixSortIncreasing(v, numberOfThreads);
+  }
+
+  template<typename T>
+  std::vector<uint32> sortDecreasing(const std::vector<T> &v, uint32 numberOfThreads)
   {
-    if (isLowSizeType<T>())
-      return countingSortIncreasing(v);
-    return STLsortIndex<T>(v, [](const T& v1, const T& v2){ return v1 > v2; });
+    return radixSortDecreasing(v, numberOfThreads);
   }
 
   template<typename T>
-  std::vector<uint32> sortDecreasing(const std::vector<T> &v)
+  void reverseLevelOrder(const std::vector<T> &v, std::vector<uint32> &R)
   {
-    if (isLowSizeType<T>())
-      return countingSortDecreasing(v);
-    return STLsortIndex<T>(v, [](const T& v1, const T& v2) { return v1 < v2; });
+    std::reverse(R.begin(), R.end());
+    for (uint32 begin = 0, end; begin < R.size(); begin = end) {
+      for (end = begin + 1; end < R.size() && v[R[end]] == v[R[begin]]; end++);
+      std::reverse(R.begin() + begin, R.begin() + end);
+    }
   }
 }
\ No newline at end of file
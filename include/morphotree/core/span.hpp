@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace morphotree
+{
+  // Non-owning view of a contiguous sequence of elements (a minimal
+  // stand-in for C++20 std::span).
+  template<class T>
+  class Span
+  {
+  public:
+    using ValueType = typename std::remove_const<T>::type;
+    using value_type = ValueType;
+    using iterator = T*;
+    using const_iterator = T*;
+
+    Span();
+    Span(T *first, T *last);
+    Span(T *data, std::size_t size);
+
+    inline T* begin() const { return first_; }
+    inline T* end() const { return last_; }
+    inline T* data() const { return first_; }
+
+    inline std::size_t size() const { return static_cast<std::size_t>(last_ - first_); }
+    inline bool empty() const { return first_ == last_; }
+
+    inline T& operator[](std::size_t idx) const { return first_[idx]; }
+    inline T& front() const { return *first_; }
+    inline T& back() const { return *(last_ - 1); }
+
+    inline operator std::vector<ValueType>() const { return std::vector<ValueType>(first_, last_); }
+
+  private:
+    T *first_;
+    T *last_;
+  };
+
+  // ===================== [ IMPLEMENTATION ] ==================================
+  template<class T>
+  Span<T>::Span()
+    :first_{nullptr}, last_{nullptr}
+  {}
+
+  template<class T>
+  Span<T>::Span(T *first, T *last)
+    :first_{first}, last_{last}
+  {}
+
+  template<class T>
+  Span<T>::Span(T *data, std::size_t size)
+    :first_{data}, last_{data + size}
+  {}
+}
\ No newline at end of file
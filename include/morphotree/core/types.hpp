@@ -1,6 +1,7 @@
 #pragma once
 
 #include <numeric>
+#include <type_traits>
 #include "morphotree/core/alias.hpp"
 
 namespace morphotree 
@@ -14,13 +15,14 @@ namespace morphotree
  
 // ===============[ IMPLEMENTATION ] ================================================= 
 
+  // types whose values can be counted in a single pass (at most 2^16
+  // counters). 32-bit types are not: they are sorted by the radix sort.
   template<typename T>
   bool isLowSizeType() 
   {
     return std::is_same<T, bool>::value || 
       std::is_same<T, uint8>::value || std::is_same<T, int8>::value ||
-      std::is_same<T, uint16>::value || std::is_same<T, int16>::value ||
-      std::is_same<T, uint32>::value || std::is_same<T, int32>::value;
+      std::is_same<T, uint16>::value || std::is_same<T, int16>::value;
   }
 
   template<typename T>
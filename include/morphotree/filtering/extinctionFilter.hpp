@@ -8,25 +8,54 @@
 
 namespace morphotree
 {
-  template<class ValueType, class AttrType>
-  MorphologicalTree<ValueType> extinctionFilter(const MorphologicalTree<ValueType> &tree,
+  template<class ValueType, class AttrType, class IndexType = uint32>
+  MorphologicalTree<ValueType, IndexType>
+  extinctionFilter(const MorphologicalTree<ValueType, IndexType> &tree,
     const std::vector<AttrType> &attr, uint32 numberOfLeavesToKeep);
 
-  template<class ValueType, class AttrType>
-  void iextinctionFilter(MorphologicalTree<ValueType> &tree, const std::vector<AttrType> &attr,
+  template<class ValueType, class AttrType, class IndexType = uint32>
+  void iextinctionFilter(MorphologicalTree<ValueType, IndexType> &tree,
+    const std::vector<AttrType> &attr,
     uint32 numberOfLeavesToKeep);
 
+  // Image of the extinction filter, reconstructed directly from the keep
+  // mask without copying and filtering the tree.
+  template<class ValueType, class AttrType, class IndexType = uint32>
+  std::vector<ValueType> extinctionFilterImage(const MorphologicalTree<ValueType, IndexType> &tree,
+    const std::vector<AttrType> &attr, uint32 numberOfLeavesToKeep);
+
+  // Keep mask (indexed by node id) of the extinction filter. It can be
+  // used to build a FilteredTreeView.
+  template<class ValueType, class AttrType, class IndexType = uint32>
+  std::vector<bool> extinctionFilterKeep(const MorphologicalTree<ValueType, IndexType> &tree,
+    const std::vector<AttrType> &attr, uint32 numberOfLeavesToKeep);
+
 
   // ============================ [ IMPLEMENTATION ] ===============================================
-  template<class ValueType, class AttrType>
-  void iextinctionFilter(MorphologicalTree<ValueType> &tree, const std::vector<AttrType> &attr, 
+  template<class ValueType, class AttrType, class IndexType>
+  void iextinctionFilter(MorphologicalTree<ValueType, IndexType> &tree,
+    const std::vector<AttrType> &attr, 
     uint32 numberOfLeavesToKeep)
   {
-    using NodePtr = typename MorphologicalTree<ValueType>::NodePtr;
-    using MapType = typename ExtinctionValueLeavesComputer<ValueType, AttrType>::MapType;    
+    tree.idirectFilter(extinctionFilterKeep(tree, attr, numberOfLeavesToKeep));
+  }
+
+  template<class ValueType, class AttrType, class IndexType>
+  std::vector<ValueType> extinctionFilterImage(const MorphologicalTree<ValueType, IndexType> &tree,
+    const std::vector<AttrType> &attr, uint32 numberOfLeavesToKeep)
+  {
+    return tree.reconstructImage(extinctionFilterKeep(tree, attr, numberOfLeavesToKeep));
+  }
+
+  template<class ValueType, class AttrType, class IndexType>
+  std::vector<bool> extinctionFilterKeep(const MorphologicalTree<ValueType, IndexType> &tree,
+    const std::vector<AttrType> &attr, uint32 numberOfLeavesToKeep)
+  {
+    using NodePtr = typename MorphologicalTree<ValueType, IndexType>::NodePtr;
+    using MapType = typename ExtinctionValueLeavesComputer<ValueType, AttrType, IndexType>::MapType;    
     using KeyValuePair = std::pair<uint32, AttrType>;
 
-    MapType extLeaves = ExtinctionValueLeavesComputer<ValueType, AttrType>().compute(tree, attr);
+    MapType extLeaves = ExtinctionValueLeavesComputer<ValueType, AttrType, IndexType>().compute(tree, attr);
 
     if (numberOfLeavesToKeep < extLeaves.size()) {
       std::vector<KeyValuePair> items(extLeaves.begin(), extLeaves.end());
@@ -40,7 +69,7 @@ namespace morphotree
         keep[items[i].first] = true;
       }
 
-      tree.tranverse([&keep](NodePtr node) {
+      tree.forEachPostOrder([&keep](NodePtr node) {
         NodePtr parent = node->parent();
         if (parent != nullptr && !keep[parent->id()]) {
           keep[parent->id()] = keep[node->id()];
@@ -48,16 +77,18 @@ namespace morphotree
       });
 
       keep[tree.root()->id()] = true;      
-      tree.idirectFilter([&keep](NodePtr node) { return keep[node->id()]; });
-    }    
+      return keep;
+    }
+
+    // every leaf is kept: nothing to filter.
+    return std::vector<bool>(tree.numberOfNodes(), true);
   }
 
-  template<class ValueType, class AttrType>
-  MorphologicalTree<ValueType> extinctionFilter(const MorphologicalTree<ValueType> &tree,
+  template<class ValueType, class AttrType, class IndexType>
+  MorphologicalTree<ValueType, IndexType>
+  extinctionFilter(const MorphologicalTree<ValueType, IndexType> &tree,
     const std::vector<AttrType> &attr, uint32 numberOfLeavesToKeep)
   {
-    MorphologicalTree<ValueType> ctree = tree.copy();
-    iextinctionFilter(ctree, attr, numberOfLeavesToKeep);
-    return ctree;
+    return tree.directFilter(extinctionFilterKeep(tree, attr, numberOfLeavesToKeep));
   }
 }
\ No newline at end of file
@@ -101,7 +101,7 @@ namespace morphotree
     cperimeter_.resize(tree.numberOfNodes(), 0.0f);
 
     std::vector<Quads> quads = quadComputer->initAttributes(tree);
-    tree.tranverse([this, &quadComputer, &quads](NodePtr node) {
+    tree.forEachPostOrder([this, &quadComputer, &quads](NodePtr node) {
       quadComputer->computeInitialValue(quads, node);
 
       if (node->parent() != nullptr) {
@@ -127,7 +127,7 @@ namespace morphotree
   template<typename ValueType>
   void MinCPerimeterWithAbsError<ValueType>::filterNodesFromMorphoTree(MTree &tree)
   {
-    tree.idirectFilter([this](NodePtr node) { return keep_[node->id()]; });
+    tree.idirectFilter(keep_);
   }
 
   template<typename ValueType>
@@ -182,7 +182,7 @@ namespace morphotree
     resetAreaError();
     numFilteredNodes_ = 0;
 
-    tree.tranverse([this, &vabsError, &vsumPerimeter,lambda](NodePtr node) {
+    tree.forEachPostOrder([this, &vabsError, &vsumPerimeter,lambda](NodePtr node) {
       if (node->children().empty()) {
         vsumPerimeter[node->id()] = computeAccPerimeter(vsumPerimeter, node);
         vabsError[node->id()] = computeAbsError(vabsError, node);
@@ -328,4 +328,4 @@ namespace morphotree
   {
     return absError[tree.root()->id()];
   }
-}
+}
\ No newline at end of file
@@ -107,7 +107,7 @@ namespace morphotree
     cperimeter_.resize(etos.numberOfNodes(), 0.0f);
 
     sumPerimeter_ = 0.0;
-    etos.tranverse([&quads, this](NodePtr node) {
+    etos.forEachPostOrder([&quads, this](NodePtr node) {
       cperimeter_[node->id()] = quads[node->id()].continuousPerimeter();
       sumPerimeter_ += quads[node->id()].continuousPerimeter();
     });
@@ -119,7 +119,7 @@ namespace morphotree
   void MinCPerimeterWithAbsErrorToS<ValueType>::filterNodesFromMorphoTree(MTree &tree)
   {
     transformKeepToPrunning(tree);
-    tree.idirectFilter([this](NodePtr node) { return keep_[node->id()]; });
+    tree.idirectFilter(keep_);
   }
 
   template<typename ValueType>
@@ -186,7 +186,7 @@ namespace morphotree
 
     resetKeepMapping();
     numPrunnedNodes_ = 0;
-    tree.tranverse([this, &vabsError, &vsumPerimeter, lambda](NodePtr node) {
+    tree.forEachPostOrder([this, &vabsError, &vsumPerimeter, lambda](NodePtr node) {
       if (node->children().empty()) {
         vsumPerimeter[node->id()] = computeAccPerimeter(vsumPerimeter, node);
         vabsError[node->id()] = computeAbsError(vabsError, node);
@@ -325,7 +325,7 @@ namespace morphotree
   void MinCPerimeterWithAbsErrorToS<ValueType>::transformKeepToPrunning(
     const MTree &tree)
   {
-    tree.traverseByLevel([this](NodePtr node) {
+    tree.forEachBFS([this](NodePtr node) {
       if (node->parent() != nullptr) {
         if (!keep_[node->parent()->id()])
           keep_[node->id()] = false;
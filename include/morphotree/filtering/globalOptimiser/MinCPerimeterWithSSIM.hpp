@@ -116,7 +116,7 @@ namespace morphotree
     cperimeter_.resize(tree.numberOfNodes(), 0.0f);    
 
     std::vector<Quads> quads = quadComputer->initAttributes(tree);
-    tree.tranverse([this, &quadComputer, &quads](NodePtr node){
+    tree.forEachPostOrder([this, &quadComputer, &quads](NodePtr node){
       quadComputer->computeInitialValue(quads, node);
 
       if (node->parent() != nullptr) {
@@ -136,7 +136,7 @@ namespace morphotree
   template<typename ValueType>
   void MinCPerimeterWithSSIM<ValueType>::filterNodesFromMorphoTree(MTree &tree)
   {
-    tree.idirectFilter([this](NodePtr node) { return keep_[node->id()]; });
+    tree.idirectFilter(keep_);
   }
   
   template<typename ValueType>
@@ -195,7 +195,7 @@ namespace morphotree
     resetKeepMapping();
     numFilteredNodes_ = 0;
 
-    tree.tranverse([this, lambda](NodePtr node){       
+    tree.forEachPostOrder([this, lambda](NodePtr node){       
       if (!node->children().empty()) {
         std::vector<bool> keepWithPrunning = prune(node);
 
@@ -241,7 +241,7 @@ namespace morphotree
   float MinCPerimeterWithSSIM<ValueType>::computeAccPerimeter()
   {
     float accPerimeter = 0.0f;
-    tree_.tranverse([&accPerimeter, this](NodePtr node) {
+    tree_.forEachPostOrder([&accPerimeter, this](NodePtr node) {
       if (keep_[node->id()])
         accPerimeter += cperimeter_[node->id()];
     });  
@@ -254,7 +254,7 @@ namespace morphotree
     const std::vector<bool> &keepWithPrunning)
   {
     float accPerimeter = 0.0f;
-    tree_.tranverse([&accPerimeter, &keepWithPrunning, this](NodePtr node) {
+    tree_.forEachPostOrder([&accPerimeter, &keepWithPrunning, this](NodePtr node) {
       if (keepWithPrunning[node->id()])
         accPerimeter += cperimeter_[node->id()];
     });
@@ -265,8 +265,7 @@ namespace morphotree
   template<typename ValueType>
   float MinCPerimeterWithSSIM<ValueType>::computeSSIM()
   {
-    std::vector<ValueType> frec = 
-      tree_.reconstructImage([this](NodePtr node) { return keep_[node->id()]; });
+    std::vector<ValueType> frec = tree_.reconstructImage(keep_);
     return 1.f - ssim_.compute(domain_, f_, frec);
   }
 
@@ -274,10 +273,7 @@ namespace morphotree
   float MinCPerimeterWithSSIM<ValueType>::computeFilteredChildrenSSIM(
     const std::vector<bool> &keepWithPrunnig)
   {
-    std::vector<ValueType> frec = 
-      tree_.reconstructImage([this, &keepWithPrunnig](NodePtr node){ 
-        return keepWithPrunnig[node->id()];
-      });
+    std::vector<ValueType> frec = tree_.reconstructImage(keepWithPrunnig);
     
     return 1.f - ssim_.compute(domain_, f_, frec);
   }
@@ -106,7 +106,7 @@ namespace morphotree
     cperimeter_.resize(etos.numberOfNodes(), 0.0f);
     
     sumPerimeter_ = 0.0;
-    etos.tranverse([&quads, this](NodePtr node) {
+    etos.forEachPostOrder([&quads, this](NodePtr node) {
       cperimeter_[node->id()] = quads[node->id()].continuousPerimeter();
       sumPerimeter_ += quads[node->id()].continuousPerimeter();
     });
@@ -118,7 +118,7 @@ namespace morphotree
   void MinCPerimeterWithSquaredErrorToS<ValueType>::filterNodesFromMorphoTree(MTree &tree)
   {
     transformKeepToPrunning(tree);
-    tree.idirectFilter([this](NodePtr node) { return keep_[node->id()]; });
+    tree.idirectFilter(keep_);
   }
 
   template<typename ValueType>
@@ -185,7 +185,7 @@ namespace morphotree
 
     resetKeepMapping();
     numPrunnedNodes_ = 0;
-    tree.tranverse([this, &vsquaredError, &vsumPerimeter, lambda](NodePtr node) {
+    tree.forEachPostOrder([this, &vsquaredError, &vsumPerimeter, lambda](NodePtr node) {
       if (node->children().empty()) {
         vsumPerimeter[node->id()] = computeAccPerimeter(vsumPerimeter, node);
         vsquaredError[node->id()] = computeSquaredError(vsquaredError, node);
@@ -323,7 +323,7 @@ namespace morphotree
   void MinCPerimeterWithSquaredErrorToS<ValueType>::transformKeepToPrunning(
     const MTree &tree)
   {
-    tree.traverseByLevel([this](NodePtr node) {
+    tree.forEachBFS([this](NodePtr node) {
       if (node->parent() != nullptr) {
         if (!keep_[node->parent()->id()])
           keep_[node->id()] = false;
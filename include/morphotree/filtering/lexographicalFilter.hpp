@@ -6,32 +6,45 @@
 
 namespace morphotree
 {
-  template<class ValueType>
-  MorphologicalTree<ValueType> filterTreeLexographically(const MorphologicalTree<ValueType> &tree, 
+  template<class ValueType, class IndexType = uint32>
+  MorphologicalTree<ValueType, IndexType>
+  filterTreeLexographically(const MorphologicalTree<ValueType, IndexType> &tree, 
     const std::vector<uint32> &order, uint32 numberOfNodesToBeKept);  
   
-  template<class ValueType>
-  void ifilterTreeLexographically(MorphologicalTree<ValueType> &tree, 
+  template<class ValueType, class IndexType = uint32>
+  void ifilterTreeLexographically(MorphologicalTree<ValueType, IndexType> &tree, 
+    const std::vector<uint32> &order, uint32 numberOfNodesToBeKept);
+
+  // Keep mask (indexed by node id) of the lexicographical filter. It can be
+  // used to build a FilteredTreeView.
+  template<class ValueType, class IndexType = uint32>
+  std::vector<bool> lexographicalFilterKeep(const MorphologicalTree<ValueType, IndexType> &tree,
     const std::vector<uint32> &order, uint32 numberOfNodesToBeKept);
 
   // ========================== [ IMPLEMENTATION ] ================================================
-  template<class ValueType>
-  void ifilterTreeLexographically(MorphologicalTree<ValueType> &tree, 
+  template<class ValueType, class IndexType>
+  void ifilterTreeLexographically(MorphologicalTree<ValueType, IndexType> &tree, 
     const std::vector<uint32> &order, uint32 numberOfNodesToBeKept)
   {
-    using NodePtr = typename MorphologicalTree<ValueType>::NodePtr;
+    tree.idirectFilter(lexographicalFilterKeep(tree, order, numberOfNodesToBeKept));
+  }
 
-    tree.idirectFilter([&order, numberOfNodesToBeKept](NodePtr node) {
-      return order[node->id()] < numberOfNodesToBeKept;
-    });
+  template<class ValueType, class IndexType>
+  MorphologicalTree<ValueType, IndexType>
+  filterTreeLexographically(const MorphologicalTree<ValueType, IndexType> &tree,
+    const std::vector<uint32> &order, uint32 numberOfNodesToBeKept)
+  {
+    return tree.directFilter(lexographicalFilterKeep(tree, order, numberOfNodesToBeKept));
   }
 
-  template<class ValueType>
-  MorphologicalTree<ValueType> filterTreeLexographically(const MorphologicalTree<ValueType> &tree,
+  template<class ValueType, class IndexType>
+  std::vector<bool> lexographicalFilterKeep(const MorphologicalTree<ValueType, IndexType> &tree,
     const std::vector<uint32> &order, uint32 numberOfNodesToBeKept)
   {
-    MorphologicalTree<ValueType> ctree = tree.copy();
-    ifilterTreeLexographically(ctree, order, numberOfNodesToBeKept);
-    return ctree;
+    std::vector<bool> keep(tree.numberOfNodes());
+    for (uint32 id = 0; id < keep.size(); id++) {
+      keep[id] = order[id] < numberOfNodesToBeKept;
+    }
+    return keep;
   }
 }
\ No newline at end of file
@@ -10,29 +10,43 @@
 
 namespace morphotree 
 {
-  template<class ValueType, class AttrType>
-  MorphologicalTree<ValueType> progressiveDifferenceFilter(const MorphologicalTree<ValueType>& tree, 
+  template<class ValueType, class AttrType, class IndexType = uint32>
+  MorphologicalTree<ValueType, IndexType>
+  progressiveDifferenceFilter(const MorphologicalTree<ValueType, IndexType>& tree, 
     const std::vector<AttrType> &attr, AttrType threshold);
   
-  template<class ValueType, class AttrType>
-  void iprogressiveDifferenceFilter(MorphologicalTree<ValueType> &tree, 
+  template<class ValueType, class AttrType, class IndexType = uint32>
+  void iprogressiveDifferenceFilter(MorphologicalTree<ValueType, IndexType> &tree, 
+    const std::vector<AttrType> &attr, AttrType threshold);
+
+  // Keep mask (indexed by node id) of the progressive difference filter. 
+  // It can be used to build a FilteredTreeView.
+  template<class ValueType, class AttrType, class IndexType = uint32>
+  std::vector<bool> progressiveDifferenceFilterKeep(const MorphologicalTree<ValueType, IndexType> &tree, 
     const std::vector<AttrType> &attr, AttrType threshold);
 
   // =====================[ IMPLEMENTATION ] ===============================================================
-  template<class ValueType, class AttrType>
-  MorphologicalTree<ValueType> progressiveDifferenceFilter(const MorphologicalTree<ValueType> &tree, 
+  template<class ValueType, class AttrType, class IndexType>
+  MorphologicalTree<ValueType, IndexType>
+  progressiveDifferenceFilter(const MorphologicalTree<ValueType, IndexType> &tree, 
     const std::vector<AttrType> &attr, AttrType threshold)
   {
-    MorphologicalTree<ValueType> ctree = tree.copy();
-    iprogressiveDifferenceFilter(ctree, attr, threshold);
-    return ctree;
+    return tree.directFilter(progressiveDifferenceFilterKeep(tree, attr, threshold));
   }
 
-  template<class ValueType, class AttrType>
-  void iprogressiveDifferenceFilter(MorphologicalTree<ValueType> &tree, const std::vector<AttrType> &attr,
+  template<class ValueType, class AttrType, class IndexType>
+  void iprogressiveDifferenceFilter(MorphologicalTree<ValueType, IndexType> &tree,
+    const std::vector<AttrType> &attr,
     AttrType threshold)
   {
-    using MTree = MorphologicalTree<ValueType>;    
+    tree.idirectFilter(progressiveDifferenceFilterKeep(tree, attr, threshold));
+  }
+
+  template<class ValueType, class AttrType, class IndexType>
+  std::vector<bool> progressiveDifferenceFilterKeep(const MorphologicalTree<ValueType, IndexType> &tree, 
+    const std::vector<AttrType> &attr, AttrType threshold)
+  {
+    using MTree = MorphologicalTree<ValueType, IndexType>;    
     using NodePtr = typename MTree::NodePtr;
     using Stack = std::stack<NodePtr>;
 
@@ -40,7 +54,7 @@ namespace morphotree
     std::vector<bool> visited(tree.numberOfNodes(), false);
     std::vector<bool> keep(tree.numberOfNodes(), false);
 
-    tree.tranverse([&leaves](NodePtr node) {
+    tree.forEachPostOrder([&leaves](NodePtr node) {
       if (node->children().size() <= 0)
         leaves.push_back(node);
     });
@@ -73,7 +87,7 @@ namespace morphotree
       }
     }
 
-    tree.idirectFilter([&keep](NodePtr node) { return keep[node->id()]; });    
+    return keep;
   }
 
 }
\ No newline at end of file
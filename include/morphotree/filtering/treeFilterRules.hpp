@@ -4,43 +4,57 @@
 #include "morphotree/tree/mtree.hpp"
 
 #include <functional>
+#include <vector>
 
 namespace morphotree
 {
-  template<class ValueType>
-  MorphologicalTree<ValueType> maxRuleFilter(const MorphologicalTree<ValueType> &tree,
-    std::function<bool(typename MorphologicalTree<ValueType>::NodePtr)> keep);
+  template<class ValueType, class IndexType = uint32>
+  MorphologicalTree<ValueType, IndexType>
+  maxRuleFilter(const MorphologicalTree<ValueType, IndexType> &tree,
+    std::function<bool(typename MorphologicalTree<ValueType, IndexType>::NodePtr)> keep);
 
-  template<class ValueType>
-  void imaxRuleFilter(MorphologicalTree<ValueType> &tree, 
-    std::function<bool(typename MorphologicalTree<ValueType>::NodePtr)> keep);
+  template<class ValueType, class IndexType = uint32>
+  void imaxRuleFilter(MorphologicalTree<ValueType, IndexType> &tree, 
+    std::function<bool(typename MorphologicalTree<ValueType, IndexType>::NodePtr)> keep);
+
+  // Keep mask (indexed by node id) of the max-rule filter. It can be used
+  // to build a FilteredTreeView.
+  template<class ValueType, class IndexType = uint32>
+  std::vector<bool> maxRuleFilterKeep(const MorphologicalTree<ValueType, IndexType> &tree,
+    std::function<bool(typename MorphologicalTree<ValueType, IndexType>::NodePtr)> keep);
 
   // ======================[ IMPLEMENTATION ] ===================================================
-  template<class ValueType>
-  MorphologicalTree<ValueType> maxRuleFilter(const MorphologicalTree<ValueType> &tree,
-    std::function<bool(typename MorphologicalTree<ValueType>::NodePtr)> keep)
+  template<class ValueType, class IndexType>
+  MorphologicalTree<ValueType, IndexType>
+  maxRuleFilter(const MorphologicalTree<ValueType, IndexType> &tree,
+    std::function<bool(typename MorphologicalTree<ValueType, IndexType>::NodePtr)> keep)
+  {
+    return tree.directFilter(maxRuleFilterKeep(tree, keep));
+  }
+
+  template<class ValueType, class IndexType>
+  void imaxRuleFilter(MorphologicalTree<ValueType, IndexType> &tree, 
+    std::function<bool(typename MorphologicalTree<ValueType, IndexType>::NodePtr)> keep)
   {
-    MorphologicalTree<ValueType> ctree = tree.copy();
-    imaxRuleFilter(ctree, keep);
-    return ctree;
+    tree.idirectFilter(maxRuleFilterKeep(tree, keep));
   }
 
-  template<class ValueType>
-  void imaxRuleFilter(MorphologicalTree<ValueType> &tree, 
-    std::function<bool(typename MorphologicalTree<ValueType>::NodePtr)> keep)
+  template<class ValueType, class IndexType>
+  std::vector<bool> maxRuleFilterKeep(const MorphologicalTree<ValueType, IndexType> &tree,
+    std::function<bool(typename MorphologicalTree<ValueType, IndexType>::NodePtr)> keep)
   {
-    using MTree = MorphologicalTree<ValueType>;
+    using MTree = MorphologicalTree<ValueType, IndexType>;
     using NodePtr = typename MTree::NodePtr;
 
     std::vector<bool> shouldKeep(tree.numberOfNodes(), false);
 
-    tree.tranverse([&shouldKeep, keep](NodePtr node) { shouldKeep[node->id()] = keep(node); });
-    tree.tranverse([&shouldKeep](NodePtr node){
+    tree.forEachPostOrder([&shouldKeep, keep](NodePtr node) { shouldKeep[node->id()] = keep(node); });
+    tree.forEachPostOrder([&shouldKeep](NodePtr node){
       if (node->parent() != nullptr && shouldKeep[node->id()]) {
         shouldKeep[node->parent()->id()] = true;
       }
     });
 
-    tree.idirectFilter([&shouldKeep](NodePtr node) { return shouldKeep[node->id()]; });
+    return shouldKeep;
   }
 }
\ No newline at end of file
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+#include "morphotree/tree/mtree.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace morphotree
+{
+  // AncestorIndex answers ancestor queries on a MorphologicalTree in
+  // O(log n) using jump pointers (binary lifting): jump(k, id) is the
+  // 2^k-th ancestor of "id", saturated at the root. It takes
+  // O(n log n) memory and keeps a reference to the tree, which must
+  // outlive the index and must not be filtered while the index is in use.
+  template<class WeightType>
+  class AncestorIndex
+  {
+  public:
+    using TreeType = MorphologicalTree<WeightType>;
+
+    AncestorIndex(const TreeType &tree);
+
+    inline const TreeType& tree() const { return *tree_; }
+    inline uint32 depth(uint32 nodeId) const { return depth_[nodeId]; }
+
+    // k-th ancestor of "nodeId" (the node itself for k = 0), or
+    // UndefinedIndex if "nodeId" has less than k ancestors.
+    uint32 ancestor(uint32 nodeId, uint32 k) const;
+
+    // lowest common ancestor of "nodeA" and "nodeB".
+    uint32 lca(uint32 nodeA, uint32 nodeB) const;
+
+    bool isAncestor(uint32 ancestorId, uint32 nodeId) const;
+
+    // Topmost ancestor (or the node itself) of "nodeId" whose level is
+    // greater than or equal to "lambda" (less than or equal to for
+    // min-trees), i.e., the connected component of the upper (lower)
+    // level set at "lambda" which contains the node. It returns
+    // UndefinedIndex if the level of the node itself does not satisfy it.
+    // Levels are assumed to be monotone along the paths to the root, as
+    // in max-trees and min-trees.
+    uint32 levelAncestor(uint32 nodeId, WeightType lambda) const;
+
+  private:
+    inline uint32 jump(uint32 k, uint32 nodeId) const { return jump_[k * numberOfNodes_ + nodeId]; }
+    inline bool inLevelSet(uint32 nodeId, WeightType lambda) const;
+
+  private:
+    const TreeType *tree_;
+    uint32 numberOfNodes_;
+    uint32 numberOfJumps_;
+    std::vector<uint32> depth_;
+    std::vector<uint32> jump_;
+  };
+
+  // ===================== [ IMPLEMENTATION ] ==================================
+  template<class WeightType>
+  AncestorIndex<WeightType>::AncestorIndex(const TreeType &tree)
+    :tree_{&tree}, numberOfNodes_{tree.numberOfNodes()}, numberOfJumps_{1}
+  {
+    // parent(id) < id: depths are computed in increasing id order.
+    depth_.assign(numberOfNodes_, 0);
+    uint32 maxDepth = 0;
+    for (uint32 id = 1; id < numberOfNodes_; id++) {
+      depth_[id] = depth_[tree.parent(id)] + 1;
+      if (depth_[id] > maxDepth)
+        maxDepth = depth_[id];
+    }
+
+    while ((uint32(1) << numberOfJumps_) <= maxDepth)
+      numberOfJumps_++;
+
+    jump_.resize(numberOfJumps_ * numberOfNodes_);
+    for (uint32 id = 0; id < numberOfNodes_; id++) {
+      jump_[id] = id == 0 ? 0 : tree.parent(id);
+    }
+
+    for (uint32 k = 1; k < numberOfJumps_; k++) {
+      uint32 *cur = jump_.data() + k * numberOfNodes_;
+      const uint32 *prev = jump_.data() + (k - 1) * numberOfNodes_;
+      for (uint32 id = 0; id < numberOfNodes_; id++) {
+        cur[id] = prev[prev[id]];
+      }
+    }
+  }
+
+  template<class WeightType>
+  uint32 AncestorIndex<WeightType>::ancestor(uint32 nodeId, uint32 k) const
+  {
+    if (k > depth_[nodeId])
+      return TreeType::UndefinedIndex;
+
+    for (uint32 j = 0; k > 0; j++, k >>= 1) {
+      if (k & 1)
+        nodeId = jump(j, nodeId);
+    }
+    return nodeId;
+  }
+
+  template<class WeightType>
+  uint32 AncestorIndex<WeightType>::lca(uint32 nodeA, uint32 nodeB) const
+  {
+    if (depth_[nodeA] < depth_[nodeB])
+      std::swap(nodeA, nodeB);
+
+    nodeA = ancestor(nodeA, depth_[nodeA] - depth_[nodeB]);
+    if (nodeA == nodeB)
+      return nodeA;
+
+    for (uint32 k = numberOfJumps_; k > 0; k--) {
+      if (jump(k - 1, nodeA) != jump(k - 1, nodeB)) {
+        nodeA = jump(k - 1, nodeA);
+        nodeB = jump(k - 1, nodeB);
+      }
+    }
+    return jump(0, nodeA);
+  }
+
+  template<class WeightType>
+  bool AncestorIndex<WeightType>::isAncestor(uint32 ancestorId, uint32 nodeId) const
+  {
+    return depth_[ancestorId] <= depth_[nodeId] &&
+      ancestor(nodeId, depth_[nodeId] - depth_[ancestorId]) == ancestorId;
+  }
+
+  template<class WeightType>
+  bool AncestorIndex<WeightType>::inLevelSet(uint32 nodeId, WeightType lambda) const
+  {
+    if (tree_->type() == MorphoTreeType::MinTree)
+      return tree_->level(nodeId) <= lambda;
+    return tree_->level(nodeId) >= lambda;
+  }
+
+  template<class WeightType>
+  uint32 AncestorIndex<WeightType>::levelAncestor(uint32 nodeId, WeightType lambda) const
+  {
+    if (!inLevelSet(nodeId, lambda))
+      return TreeType::UndefinedIndex;
+
+    for (uint32 k = numberOfJumps_; k > 0; k--) {
+      uint32 a = jump(k - 1, nodeId);
+      if (inLevelSet(a, lambda))
+        nodeId = a;
+    }
+    return nodeId;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+#include "morphotree/adjacency/adjacency.hpp"
+#include "morphotree/adjacency/adjacencyDispatch.hpp"
+#include "morphotree/tree/ct_builder.hpp"
+
+#include <omp.h>
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
+#include <limits>
+#include <memory>
+
+namespace morphotree
+{
+  // ConcurrentCTBuilder computes the same CTBuilderResult as CTBuilder with
+  // a concurrent union-find shared by all threads: there is no partition
+  // of the domain. The levels are processed in the order of R; the
+  // elements of a level are united with their processed neighbours
+  // concurrently, linking roots with compare-and-swap on "zpar" and always
+  // towards the root processed last in R. Hence the root of a component is
+  // the level root chosen by CTBuilder, and the parents of a level are set
+  // once all of its unions are done. Levels with few elements are run by a
+  // single thread, so images with many levels (e.g. float images) do not
+  // pay a barrier per level. R must be sorted by level, as produced by
+  // sortIncreasing and sortDecreasing.
+  template<class WeightType>
+  class ConcurrentCTBuilder
+  {
+  public:
+    ConcurrentCTBuilder(uint32 numberOfThreads);
+
+    inline uint32 numberOfThreads() const { return numberOfThreads_; }
+
+    CTBuilderResult build(const std::vector<WeightType> &f,
+                          std::shared_ptr<Adjacency> adj,
+                          std::vector<uint32> R);
+
+    template<class AdjacencyType, class = RequireAdjacency<AdjacencyType>>
+    CTBuilderResult build(const std::vector<WeightType> &f,
+                          const AdjacencyType &adj,
+                          std::vector<uint32> R);
+
+  private:
+    // runs of consecutive levels of R: [begin, end). A parallel run holds a
+    // single level.
+    struct LevelRun
+    {
+      uint32 begin;
+      uint32 end;
+      bool parallel;
+    };
+
+    static const uint32 MinParallelLevelSize;
+
+    std::vector<LevelRun> levelRuns(const std::vector<WeightType> &f,
+      const std::vector<uint32> &R) const;
+    template<class AdjacencyType>
+    void uniteLevel(uint32 begin, uint32 end, const std::vector<WeightType> &f,
+      const AdjacencyType &adj, const std::vector<uint32> &R,
+      std::vector<uint32> &oldRoots);
+    void unite(uint32 x, uint32 y, const std::vector<WeightType> &f, WeightType level,
+      std::vector<uint32> &oldRoots);
+    uint32 findRoot(uint32 x);
+
+    inline bool isDeeper(WeightType a, WeightType b) const { return decreasing_ ? a > b : a < b; }
+
+  private:
+    uint32 numberOfThreads_;
+    bool decreasing_;
+    std::vector<uint32> rank_;
+    std::vector<std::atomic<uint32>> zpar_;
+  };
+
+  template<class WeightType>
+  const uint32 ConcurrentCTBuilder<WeightType>::MinParallelLevelSize = 4096;
+
+  // =============== [IMPLEMENTATION] ==================================================
+  template<class WeightType>
+  ConcurrentCTBuilder<WeightType>::ConcurrentCTBuilder(uint32 numberOfThreads)
+    :numberOfThreads_{std::max<uint32>(numberOfThreads, 1)}, decreasing_{true}
+  {}
+
+  template<class WeightType>
+  CTBuilderResult ConcurrentCTBuilder<WeightType>::build(const std::vector<WeightType> &f,
+    std::shared_ptr<Adjacency> adj, std::vector<uint32> R)
+  {
+    return withStaticAdjacency(*adj, [&](const auto &a) { return build(f, a, std::move(R)); });
+  }
+
+  template<class WeightType>
+  template<class AdjacencyType, class>
+  CTBuilderResult ConcurrentCTBuilder<WeightType>::build(const std::vector<WeightType> &f,
+    const AdjacencyType &adj, std::vector<uint32> R)
+  {
+    const int numberOfElements = static_cast<int>(f.size());
+    decreasing_ = R.empty() || f[R.front()] >= f[R.back()];
+    rank_.resize(f.size());
+    zpar_ = std::vector<std::atomic<uint32>>(f.size());
+    std::vector<uint32> parent(f.size());
+    std::vector<LevelRun> runs = levelRuns(f, R);
+
+    #pragma omp parallel for num_threads(numberOfThreads_)
+    for (int i = 0; i < numberOfElements; i++) {
+      rank_[R[i]] = i;
+    }
+
+    #pragma omp parallel num_threads(numberOfThreads_)
+    {
+      // roots of components of the previous levels linked by this thread
+      // during the current level.
+      std::vector<uint32> oldRoots;
+      for (const LevelRun &run : runs) {
+        if (run.parallel) {
+          const int begin = run.begin, end = run.end;
+
+          #pragma omp for
+          for (int i = begin; i < end; i++)
+            zpar_[R[i]].store(R[i], std::memory_order_relaxed);
+
+          #pragma omp for schedule(dynamic, 256)
+          for (int i = begin; i < end; i++)
+            adj.forEachNeighbour(R[i], [&](uint32 n) {
+              if (!isDeeper(f[R[i]], f[n]))
+                unite(R[i], n, f, f[R[i]], oldRoots);
+            });
+
+          for (uint32 r : oldRoots)
+            parent[r] = findRoot(r);
+          oldRoots.clear();
+
+          #pragma omp for
+          for (int i = begin; i < end; i++)
+            parent[R[i]] = findRoot(R[i]);
+        }
+        else {
+          #pragma omp single
+          {
+            for (uint32 begin = run.begin, end; begin < run.end; begin = end) {
+              for (end = begin + 1; end < run.end && f[R[end]] == f[R[begin]]; end++);
+              uniteLevel(begin, end, f, adj, R, oldRoots);
+              for (uint32 r : oldRoots)
+                parent[r] = findRoot(r);
+              oldRoots.clear();
+              for (uint32 i = begin; i < end; i++)
+                parent[R[i]] = findRoot(R[i]);
+            }
+          }
+        }
+      }
+    }
+
+    return CTBuilderResult{std::move(parent), std::move(R)};
+  }
+
+  template<class WeightType>
+  std::vector<typename ConcurrentCTBuilder<WeightType>::LevelRun>
+  ConcurrentCTBuilder<WeightType>::levelRuns(const std::vector<WeightType> &f,
+    const std::vector<uint32> &R) const
+  {
+    std::vector<LevelRun> runs;
+    for (uint32 begin = 0, end; begin < R.size(); begin = end) {
+      for (end = begin + 1; end < R.size() && f[R[end]] == f[R[begin]]; end++);
+
+      bool parallel = end - begin >= MinParallelLevelSize;
+      if (!parallel && !runs.empty() && !runs.back().parallel)
+        runs.back().end = end;
+      else
+        runs.push_back(LevelRun{begin, end, parallel});
+    }
+    return runs;
+  }
+
+  template<class WeightType>
+  template<class AdjacencyType>
+  void ConcurrentCTBuilder<WeightType>::uniteLevel(uint32 begin, uint32 end,
+    const std::vector<WeightType> &f, const AdjacencyType &adj,
+    const std::vector<uint32> &R, std::vector<uint32> &oldRoots)
+  {
+    for (uint32 i = begin; i < end; i++)
+      zpar_[R[i]].store(R[i], std::memory_order_relaxed);
+
+    for (uint32 i = begin; i < end; i++)
+      adj.forEachNeighbour(R[i], [&](uint32 n) {
+        if (!isDeeper(f[R[i]], f[n]))
+          unite(R[i], n, f, f[R[i]], oldRoots);
+      });
+  }
+
+  template<class WeightType>
+  void ConcurrentCTBuilder<WeightType>::unite(uint32 x, uint32 y,
+    const std::vector<WeightType> &f, WeightType level, std::vector<uint32> &oldRoots)
+  {
+    // links always point to an element with a greater rank, so a failed
+    // compare-and-swap only means that "x" stopped being a root: both roots
+    // are searched again.
+    while (true) {
+      x = findRoot(x);
+      y = findRoot(y);
+      if (x == y)
+        return;
+      if (rank_[x] > rank_[y])
+        std::swap(x, y);
+
+      uint32 expected = x;
+      if (zpar_[x].compare_exchange_strong(expected, y)) {
+        if (f[x] != level)
+          oldRoots.push_back(x);
+        return;
+      }
+    }
+  }
+
+  template<class WeightType>
+  uint32 ConcurrentCTBuilder<WeightType>::findRoot(uint32 x)
+  {
+    // path halving. A concurrent write may be lost, which is harmless since
+    // every write points to an ancestor.
+    while (true) {
+      uint32 p = zpar_[x].load(std::memory_order_relaxed);
+      if (p == x)
+        return x;
+      uint32 gp = zpar_[p].load(std::memory_order_relaxed);
+      if (gp == p)
+        return p;
+      zpar_[x].store(gp, std::memory_order_relaxed);
+      x = gp;
+    }
+  }
+}
\ No newline at end of file
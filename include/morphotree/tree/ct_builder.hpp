@@ -1,99 +1,242 @@
 #pragma once
 
 #include "morphotree/adjacency/adjacency.hpp"
+#include "morphotree/adjacency/adjacencyDispatch.hpp"
+#include "morphotree/core/paddedImage.hpp"
+#include "morphotree/core/copyCounter.hpp"
 #include <functional>
+#include <utility>
 #include <vector>
 #include <limits>
 #include <memory>
+#include <stdexcept>
+#include <type_traits>
 
 namespace morphotree
 {
-  struct CTBuilderResult
+  // The arrays are taken by value and moved in, so a result built from
+  // rvalues holds the buffers of the caller without copying them. Copies
+  // of a result are counted by CopyCounter. IndexType is the type of the
+  // element indices (see CTBuilder).
+  template<class IndexType>
+  struct BasicCTBuilderResult
   {
-    CTBuilderResult(const std::vector<uint32> par, std::vector<uint32> r)
-      :parent{par}, R{r}
+    BasicCTBuilderResult(std::vector<IndexType> par, std::vector<IndexType> r)
+      :parent{std::move(par)}, R{std::move(r)}
     {}
 
-    std::vector<uint32> parent;
-    std::vector<uint32> R;
+    BasicCTBuilderResult(const BasicCTBuilderResult &other)
+      :parent{other.parent}, R{other.R}
+    {
+      CopyCounter::increment();
+    }
+
+    BasicCTBuilderResult(BasicCTBuilderResult &&other) = default;
+
+    BasicCTBuilderResult& operator=(const BasicCTBuilderResult &other)
+    {
+      parent = other.parent;
+      R = other.R;
+      CopyCounter::increment();
+      return *this;
+    }
+
+    BasicCTBuilderResult& operator=(BasicCTBuilderResult &&other) = default;
+
+    std::vector<IndexType> parent;
+    std::vector<IndexType> R;
   };
 
-  template<class WeightType>
+  using CTBuilderResult = BasicCTBuilderResult<uint32>;
+
+  // CTBuilder computes the component tree of "f" by union-find over the
+  // elements in the order R (Berger et al.): the sets of "zpar" are merged
+  // by rank and found iteratively with path halving, and "repr" holds the
+  // node root of every set, so the processed element "p" is linked to the
+  // node roots of its neighbouring sets rather than to the roots of "zpar"
+  // (level compression). As in the original algorithm, "p" is the node
+  // root of its set and the level root of a node is its element which
+  // comes last in R; canoniseTree resolves the same-level links in a single
+  // reverse pass over R.
+  // The neighbours are visited with forEachNeighbour of the static type of
+  // the adjacency; the adjacencies of the library given as an Adjacency are
+  // dispatched to their own type by withStaticAdjacency. The builds which
+  // return a CTBuilderResult take R by value and move it into the result.
+  // The element indices are stored as IndexType (uint16 or uint32), which
+  // must hold the number of elements: its largest value marks the
+  // unprocessed elements. The adjacencies address elements as uint32, so
+  // there are at most 2^32-1 of them; larger images are left to the
+  // builders which never hold the whole tree (TiledTreeBuilder,
+  // StreamingCTBuilder).
+  template<class WeightType, class IndexType = uint32>
   class CTBuilder
   {
+    static_assert(std::is_same<IndexType, uint16>::value || std::is_same<IndexType, uint32>::value,
+      "CTBuilder supports uint16 and uint32 indices only");
+
   public:
-    CTBuilderResult build(const std::vector<WeightType> &f, 
-                          std::shared_ptr<Adjacency> adj,
-                          const std::vector<uint32> &R);
+    using ResultType = BasicCTBuilderResult<IndexType>;
+
+    ResultType build(const std::vector<WeightType> &f, 
+                     std::shared_ptr<Adjacency> adj,
+                     std::vector<IndexType> R);
+
+    template<class AdjacencyType, class = RequireAdjacency<AdjacencyType>>
+    ResultType build(const std::vector<WeightType> &f,
+                     const AdjacencyType &adj,
+                     std::vector<IndexType> R);
+
+    // writes the parent array into "parent". The buffers of the builder and
+    // "parent" are reused, so building again with the same size does not
+    // allocate.
+    template<class AdjacencyType, class = RequireAdjacency<AdjacencyType>>
+    void build(const std::vector<WeightType> &f,
+               const AdjacencyType &adj,
+               const std::vector<IndexType> &R,
+               std::vector<IndexType> &parent);
+
+    // "adj" is a PaddedAdjacency4C or PaddedAdjacency8C of the domain of
+    // "f". R and the result use the indices of the domain.
+    template<class AdjacencyType, class = RequireAdjacency<AdjacencyType>>
+    ResultType build(const PaddedImage<WeightType> &f,
+                     const AdjacencyType &adj,
+                     std::vector<IndexType> R);
 
   private:
-    static const uint32 UNDEF;  
-    void initZPar(uint32 numberOfElements);
-    uint32 findRoot(uint32 x);
-    void canoniseTree(std::vector<uint32> &r, const std::vector<uint32> &R,
+    static const IndexType UNDEF;  
+    void initZPar(IndexType numberOfElements);
+    IndexType findRoot(IndexType x);
+    void canoniseTree(std::vector<IndexType> &r, const std::vector<IndexType> &R,
       const std::vector<WeightType> &f);
 
   private:
-    std::vector<uint32> zpar_;
+    std::vector<IndexType> zpar_;
+    std::vector<uint8> rank_;
+    std::vector<IndexType> repr_;
   };
 
 
-  template<class WeightType> 
-  const uint32 CTBuilder<WeightType>::UNDEF = std::numeric_limits<uint32>::max();
+  template<class WeightType, class IndexType>
+  const IndexType CTBuilder<WeightType, IndexType>::UNDEF = std::numeric_limits<IndexType>::max();
 
   // =============== [IMPLEMENTATION] ==================================================
-  template<class WeightType>
-  CTBuilderResult CTBuilder<WeightType>::build(const std::vector<WeightType> &f, 
+  template<class WeightType, class IndexType>
+  typename CTBuilder<WeightType, IndexType>::ResultType
+  CTBuilder<WeightType, IndexType>::build(const std::vector<WeightType> &f, 
           std::shared_ptr<Adjacency> adj,
-          const std::vector<uint32> &R)
+          std::vector<IndexType> R)
   {
+    return withStaticAdjacency(*adj, [&](const auto &a) { return build(f, a, std::move(R)); });
+  }
+
+  template<class WeightType, class IndexType>
+  template<class AdjacencyType, class>
+  typename CTBuilder<WeightType, IndexType>::ResultType
+  CTBuilder<WeightType, IndexType>::build(const std::vector<WeightType> &f,
+          const AdjacencyType &adj,
+          std::vector<IndexType> R)
+  {
+    std::vector<IndexType> parent;
+    build(f, adj, R, parent);
+    return ResultType{std::move(parent), std::move(R)};
+  }
+
+  template<class WeightType, class IndexType>
+  template<class AdjacencyType, class>
+  void CTBuilder<WeightType, IndexType>::build(const std::vector<WeightType> &f,
+          const AdjacencyType &adj,
+          const std::vector<IndexType> &R,
+          std::vector<IndexType> &parent)
+  {
+    if (f.size() > std::numeric_limits<IndexType>::max())
+      throw std::runtime_error("too many elements for the index type of CTBuilder");
+    if (f.size() > std::numeric_limits<uint32>::max())
+      throw std::runtime_error("too many elements for an in-memory tree (more than uint32 holds); "
+        "build it tile by tile with TiledTreeBuilder");
+
     initZPar(f.size());
-    std::vector<uint32> parent(f.size()); 
+    parent.resize(f.size());
 
-    for (uint32 p : R) {    
+    for (IndexType p : R) {
       parent[p] = p;
       zpar_[p] = p;
-      for (uint32 n : adj->neighbours(p)) {        
-        if (zpar_[n] != UNDEF) {
-          uint32 r = findRoot(n);       
-          if (r != p) {
-            parent[r] = p;  
-            zpar_[r] = p;
-          }
-        }
-      }
+      rank_[p] = 0;
+      repr_[p] = p;
+
+      IndexType zp = p;
+      adj.forEachNeighbour(p, [&](uint32 n) {
+        if (zpar_[n] == UNDEF)
+          return;
+
+        IndexType zn = findRoot(n);
+        if (zn == zp)
+          return;
+
+        // the node root of "zn" is deeper than p or at its level; either
+        // way it goes under p, the node root of the united set.
+        parent[repr_[zn]] = p;
+
+        if (rank_[zp] < rank_[zn])
+          std::swap(zp, zn);
+        zpar_[zn] = zp;
+        if (rank_[zp] == rank_[zn])
+          rank_[zp]++;
+        repr_[zp] = p;
+      });
     }
     canoniseTree(parent, R, f);
-    return CTBuilderResult{parent, R};
   }
 
-  template<class WeightType>
-  void CTBuilder<WeightType>::initZPar(uint32 numberOfElements)
+  template<class WeightType, class IndexType>
+  template<class AdjacencyType, class>
+  typename CTBuilder<WeightType, IndexType>::ResultType
+  CTBuilder<WeightType, IndexType>::build(const PaddedImage<WeightType> &f,
+          const AdjacencyType &adj,
+          std::vector<IndexType> R)
+  {
+    // the border is never in R, so its elements stay UNDEF in "zpar" and are
+    // skipped like the neighbours outside the domain.
+    std::vector<IndexType> paddedR(R.size());
+    for (IndexType i = 0; i < R.size(); i++)
+      paddedR[i] = f.paddedIndex(R[i]);
+
+    std::vector<IndexType> paddedParent;
+    build(f.values(), adj, paddedR, paddedParent);
+    std::vector<IndexType> parent(R.size());
+    for (IndexType i = 0; i < R.size(); i++)
+      parent[R[i]] = f.imageIndex(paddedParent[paddedR[i]]);
+    return ResultType{std::move(parent), std::move(R)};
+  }
+
+  template<class WeightType, class IndexType>
+  void CTBuilder<WeightType, IndexType>::initZPar(IndexType numberOfElements)
   {
     zpar_.resize(numberOfElements);        
     std::fill(zpar_.begin(), zpar_.end(), UNDEF);
+    rank_.resize(numberOfElements);
+    repr_.resize(numberOfElements);
   }
 
-  template<class WeightType>
-  uint32 CTBuilder<WeightType>::findRoot(uint32 x)
+  template<class WeightType, class IndexType>
+  IndexType CTBuilder<WeightType, IndexType>::findRoot(IndexType x)
   { 
-    if (zpar_[x] == x){
-      return x;
-    }
-    else{
-      zpar_[x] = findRoot(zpar_[x]);
-      return zpar_[x];
+    while (zpar_[x] != x) {
+      zpar_[x] = zpar_[zpar_[x]];
+      x = zpar_[x];
     }
+    return x;
   }
 
-  template<class WeightType>
-  void CTBuilder<WeightType>::canoniseTree(std::vector<uint32> &parent, 
-    const std::vector<uint32> &R, const std::vector<WeightType> &f)
+  template<class WeightType, class IndexType>
+  void CTBuilder<WeightType, IndexType>::canoniseTree(std::vector<IndexType> &parent, 
+    const std::vector<IndexType> &R, const std::vector<WeightType> &f)
   { 
-    using RItr = std::vector<uint32>::const_reverse_iterator;
+    // parents come later in R than their children, so "q" is canonical
+    // when "p" is visited.
+    using RItr = typename std::vector<IndexType>::const_reverse_iterator;
     for (RItr rit = R.rbegin(); rit != R.rend(); rit++)
     {
-      uint32 q = parent[*rit];
+      IndexType q = parent[*rit];
       if (f[parent[q]] == f[q]) {
         parent[*rit] = parent[q];
       }
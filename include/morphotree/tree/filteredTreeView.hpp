@@ -0,0 +1,156 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+#include "morphotree/tree/mtree.hpp"
+
+#include <vector>
+
+namespace morphotree
+{
+  // FilteredTreeView is a non-destructive direct filter of a
+  // MorphologicalTree: it keeps a reference to the tree and a keep mask
+  // indexed by node id, and answers queries about the filtered tree
+  // without building it. The nodes of the view are the kept nodes of the
+  // tree and keep their ids. The root is always kept. The tree must
+  // outlive the view.
+  template<class WeightType>
+  class FilteredTreeView
+  {
+  public:
+    using TreeType = MorphologicalTree<WeightType>;
+    using NodePtr = typename TreeType::NodePtr;
+
+    FilteredTreeView(const TreeType &tree, const std::vector<bool> &keep);
+    FilteredTreeView(const TreeType &tree, std::vector<bool> &&keep);
+
+    inline const TreeType& tree() const { return *tree_; }
+    inline const std::vector<bool>& keep() const { return keep_; }
+
+    inline uint32 numberOfNodes() const { return numberOfNodes_; }
+    inline bool isKept(uint32 nodeId) const { return target_[nodeId] == nodeId; }
+
+    // kept node which contains the node "nodeId" in the filtered tree: the
+    // node itself if it is kept, its nearest kept ancestor otherwise.
+    inline uint32 keptNode(uint32 nodeId) const { return target_[nodeId]; }
+
+    // parent of a kept node in the filtered tree (UndefinedIndex for the root).
+    uint32 parent(uint32 nodeId) const;
+    NodePtr parentNode(uint32 nodeId) const;
+
+    inline NodePtr smallComponent(uint32 idx) const { return tree_->node(target_[tree_->cmap()[idx]]); }
+
+    // traversals of the kept nodes (see MorphologicalTree::forEachPostOrder
+    // and MorphologicalTree::forEachPreOrder).
+    template<class Visitor>
+    void forEachPostOrder(Visitor &&visit) const;
+
+    template<class Visitor>
+    void forEachPreOrder(Visitor &&visit) const;
+
+    std::vector<WeightType> reconstructImage() const;
+
+    TreeType materialise() const;
+    TreeType materialise(std::vector<uint32> &newId) const;
+
+  private:
+    void computeTargets();
+
+  private:
+    const TreeType *tree_;
+    std::vector<bool> keep_;
+    std::vector<uint32> target_;
+    uint32 numberOfNodes_;
+  };
+
+  // ===================== [ IMPLEMENTATION ] ==================================
+  template<class WeightType>
+  FilteredTreeView<WeightType>::FilteredTreeView(const TreeType &tree,
+    const std::vector<bool> &keep)
+    :tree_{&tree}, keep_{keep}
+  {
+    computeTargets();
+  }
+
+  template<class WeightType>
+  FilteredTreeView<WeightType>::FilteredTreeView(const TreeType &tree,
+    std::vector<bool> &&keep)
+    :tree_{&tree}, keep_{std::move(keep)}
+  {
+    computeTargets();
+  }
+
+  template<class WeightType>
+  void FilteredTreeView<WeightType>::computeTargets()
+  {
+    const std::vector<uint32> &parent = tree_->parents();
+    target_.resize(parent.size());
+    numberOfNodes_ = 0;
+    for (uint32 id = 0; id < parent.size(); id++) {
+      if (parent[id] == TreeType::UndefinedIndex || keep_[id]) {
+        target_[id] = id;
+        numberOfNodes_++;
+      }
+      else {
+        target_[id] = target_[parent[id]];
+      }
+    }
+  }
+
+  template<class WeightType>
+  uint32 FilteredTreeView<WeightType>::parent(uint32 nodeId) const
+  {
+    uint32 pid = tree_->parent(nodeId);
+    return pid == TreeType::UndefinedIndex ? pid : target_[pid];
+  }
+
+  template<class WeightType>
+  typename FilteredTreeView<WeightType>::NodePtr
+  FilteredTreeView<WeightType>::parentNode(uint32 nodeId) const
+  {
+    uint32 pid = parent(nodeId);
+    return pid == TreeType::UndefinedIndex ? nullptr : tree_->node(pid);
+  }
+
+  template<class WeightType>
+  template<class Visitor>
+  void FilteredTreeView<WeightType>::forEachPostOrder(Visitor &&visit) const
+  {
+    tree_->forEachPostOrder([this, &visit](NodePtr node) {
+      if (isKept(node->id()))
+        visit(node);
+    });
+  }
+
+  template<class WeightType>
+  template<class Visitor>
+  void FilteredTreeView<WeightType>::forEachPreOrder(Visitor &&visit) const
+  {
+    // the subtree of a kept node in the filtered tree holds the kept nodes
+    // of its subtree in the tree, so skipping is forwarded as is.
+    tree_->forEachPreOrder([this, &visit](NodePtr node) {
+      if (!isKept(node->id()))
+        return true;
+      return static_cast<bool>(visit(node));
+    });
+  }
+
+  template<class WeightType>
+  std::vector<WeightType> FilteredTreeView<WeightType>::reconstructImage() const
+  {
+    return tree_->reconstructImage(keep_);
+  }
+
+  template<class WeightType>
+  typename FilteredTreeView<WeightType>::TreeType
+  FilteredTreeView<WeightType>::materialise() const
+  {
+    return tree_->directFilter(keep_);
+  }
+
+  template<class WeightType>
+  typename FilteredTreeView<WeightType>::TreeType
+  FilteredTreeView<WeightType>::materialise(std::vector<uint32> &newId) const
+  {
+    return tree_->directFilter(keep_, newId);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,291 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+#include "morphotree/core/hierarchicalQueue.hpp"
+#include "morphotree/adjacency/adjacency.hpp"
+#include "morphotree/adjacency/adjacencyDispatch.hpp"
+#include "morphotree/tree/ct_builder.hpp"
+
+#include <type_traits>
+#include <stdexcept>
+#include <vector>
+#include <limits>
+#include <memory>
+
+namespace morphotree
+{
+  // FloodCTBuilder computes a CTBuilderResult by flooding the image from a
+  // pixel with a hierarchical queue of one level per grey value (the
+  // non-recursive algorithm of Nistér and Stewénius, in the line of
+  // Salembier's flooding): no global sort is needed. It is restricted to
+  // integer types of up to 16 bits. The result is the one of CTBuilder
+  // with the counting sort order: R is the order of sortIncreasing
+  // (sortDecreasing for min-trees), filled by a counting pass over the
+  // histogram of the flooding, and the level root of a node is its element
+  // with the greatest index, the last one in R. Hence, the nodes get the
+  // same ids, and R is a processing order which CTBuilder turns into the
+  // same parent array. The buffers of the flooding are kept by the
+  // builder, so a builder reused on images of the same size does not
+  // allocate.
+  template<class WeightType>
+  class FloodCTBuilder
+  {
+  public:
+    static constexpr bool isSupported()
+    {
+      return std::is_integral<WeightType>::value && sizeof(WeightType) <= 2;
+    }
+
+    CTBuilderResult buildMaxTree(const std::vector<WeightType> &f,
+                                 std::shared_ptr<Adjacency> adj);
+
+    CTBuilderResult buildMinTree(const std::vector<WeightType> &f,
+                                 std::shared_ptr<Adjacency> adj);
+
+    template<class AdjacencyType, class = RequireAdjacency<AdjacencyType>>
+    CTBuilderResult buildMaxTree(const std::vector<WeightType> &f,
+                                 const AdjacencyType &adj);
+
+    template<class AdjacencyType, class = RequireAdjacency<AdjacencyType>>
+    CTBuilderResult buildMinTree(const std::vector<WeightType> &f,
+                                 const AdjacencyType &adj);
+
+    // write the parent array and R of the result into "parent" and "R".
+    template<class AdjacencyType, class = RequireAdjacency<AdjacencyType>>
+    void buildMaxTree(const std::vector<WeightType> &f, const AdjacencyType &adj,
+                      std::vector<uint32> &parent, std::vector<uint32> &R);
+
+    template<class AdjacencyType, class = RequireAdjacency<AdjacencyType>>
+    void buildMinTree(const std::vector<WeightType> &f, const AdjacencyType &adj,
+                      std::vector<uint32> &parent, std::vector<uint32> &R);
+
+  private:
+    // open node on the stack of the flooding: its key, the element which
+    // represents it during the flooding and its element with the greatest
+    // index.
+    struct Component
+    {
+      uint32 key;
+      uint32 handle;
+      uint32 maxElement;
+    };
+
+    inline static uint32 valueKey(WeightType v);
+
+    // the flooding goes first towards the elements with greater "key".
+    template<class AdjacencyType, class KeyFunc>
+    void flood(const std::vector<WeightType> &f, const AdjacencyType &adj,
+      uint32 numberOfKeys, KeyFunc key, std::vector<uint32> &parent, std::vector<uint32> &R);
+
+    void closeComponents(uint32 key, uint32 p);
+
+    // parent array and R with the level roots of CTBuilder from the parent
+    // array of the flooding (which points to the handles).
+    template<class KeyFunc>
+    void relabel(uint32 numberOfKeys, KeyFunc key, std::vector<uint32> &parent,
+      std::vector<uint32> &R);
+
+  private:
+    std::vector<uint32> handleParent_;
+    std::vector<uint32> levelRoot_;
+    std::vector<uint32> counter_;
+    std::vector<bool> visited_;
+    std::vector<Component> stack_;
+    HierarchicalQueue queue_;
+  };
+
+  // =============== [IMPLEMENTATION] ==================================================
+  template<class WeightType>
+  uint32 FloodCTBuilder<WeightType>::valueKey(WeightType v)
+  {
+    return static_cast<uint32>(static_cast<int32>(v) -
+      static_cast<int32>(std::numeric_limits<WeightType>::min()));
+  }
+
+  template<class WeightType>
+  CTBuilderResult FloodCTBuilder<WeightType>::buildMaxTree(const std::vector<WeightType> &f,
+    std::shared_ptr<Adjacency> adj)
+  {
+    return withStaticAdjacency(*adj, [&](const auto &a) { return buildMaxTree(f, a); });
+  }
+
+  template<class WeightType>
+  CTBuilderResult FloodCTBuilder<WeightType>::buildMinTree(const std::vector<WeightType> &f,
+    std::shared_ptr<Adjacency> adj)
+  {
+    return withStaticAdjacency(*adj, [&](const auto &a) { return buildMinTree(f, a); });
+  }
+
+  template<class WeightType>
+  template<class AdjacencyType, class>
+  CTBuilderResult FloodCTBuilder<WeightType>::buildMaxTree(const std::vector<WeightType> &f,
+    const AdjacencyType &adj)
+  {
+    std::vector<uint32> parent, R;
+    buildMaxTree(f, adj, parent, R);
+    return CTBuilderResult{std::move(parent), std::move(R)};
+  }
+
+  template<class WeightType>
+  template<class AdjacencyType, class>
+  CTBuilderResult FloodCTBuilder<WeightType>::buildMinTree(const std::vector<WeightType> &f,
+    const AdjacencyType &adj)
+  {
+    std::vector<uint32> parent, R;
+    buildMinTree(f, adj, parent, R);
+    return CTBuilderResult{std::move(parent), std::move(R)};
+  }
+
+  template<class WeightType>
+  template<class AdjacencyType, class>
+  void FloodCTBuilder<WeightType>::buildMaxTree(const std::vector<WeightType> &f,
+    const AdjacencyType &adj, std::vector<uint32> &parent, std::vector<uint32> &R)
+  {
+    const uint32 numberOfKeys = valueKey(std::numeric_limits<WeightType>::max()) + 1;
+    flood(f, adj, numberOfKeys, [&f](uint32 p) { return valueKey(f[p]); }, parent, R);
+  }
+
+  template<class WeightType>
+  template<class AdjacencyType, class>
+  void FloodCTBuilder<WeightType>::buildMinTree(const std::vector<WeightType> &f,
+    const AdjacencyType &adj, std::vector<uint32> &parent, std::vector<uint32> &R)
+  {
+    const uint32 maxKey = valueKey(std::numeric_limits<WeightType>::max());
+    flood(f, adj, maxKey + 1, [&f, maxKey](uint32 p) { return maxKey - valueKey(f[p]); },
+      parent, R);
+  }
+
+  template<class WeightType>
+  template<class AdjacencyType, class KeyFunc>
+  void FloodCTBuilder<WeightType>::flood(const std::vector<WeightType> &f,
+    const AdjacencyType &adj, uint32 numberOfKeys, KeyFunc key,
+    std::vector<uint32> &outParent, std::vector<uint32> &R)
+  {
+    if (!isSupported())
+      throw std::runtime_error("FloodCTBuilder supports integer types of up to 16 bits only.");
+
+    const uint32 numberOfElements = f.size();
+    std::vector<uint32> &parent = handleParent_;
+    parent.resize(numberOfElements);
+    levelRoot_.resize(numberOfElements);
+
+    counter_.assign(numberOfKeys, 0);
+    for (uint32 p = 0; p < numberOfElements; p++)
+      counter_[key(p)]++;
+
+    HierarchicalQueue &queue = queue_;
+    queue.reset(counter_);
+    visited_.assign(numberOfElements, false);
+    std::vector<bool> &visited = visited_;
+    std::vector<Component> &stack = stack_;
+    stack.clear();
+
+    for (uint32 seed = 0; seed < numberOfElements; seed++) {
+      if (visited[seed])
+        continue;
+
+      uint32 current = seed;
+      visited[seed] = true;
+      stack.push_back(Component{key(seed), seed, seed});
+      while (true) {
+        // a neighbour with a greater key is flooded first: "current" goes
+        // back to the queue and the neighbour starts a new node. The
+        // remaining neighbours are left unvisited, to be seen when
+        // "current" is popped again.
+        const uint32 p = current;
+        adj.forEachNeighbour(p, [&](uint32 n) {
+          if (current != p || visited[n])
+            return;
+          visited[n] = true;
+          if (key(n) > key(p)) {
+            queue.push(key(p), p);
+            stack.push_back(Component{key(n), n, n});
+            current = n;
+            return;
+          }
+          queue.push(key(n), n);
+        });
+        if (current != p)
+          continue;
+
+        Component &top = stack.back();
+        if (current != top.handle) {
+          parent[current] = top.handle;
+          if (current > top.maxElement)
+            top.maxElement = current;
+        }
+
+        if (queue.empty())
+          break;
+
+        current = queue.pop();
+        if (key(current) < stack.back().key)
+          closeComponents(key(current), current);
+      }
+
+      while (!stack.empty()) {
+        Component c = stack.back();
+        stack.pop_back();
+        levelRoot_[c.handle] = c.maxElement;
+        parent[c.handle] = stack.empty() ? c.handle : stack.back().handle;
+      }
+    }
+
+    relabel(numberOfKeys, key, outParent, R);
+  }
+
+  template<class WeightType>
+  void FloodCTBuilder<WeightType>::closeComponents(uint32 key, uint32 p)
+  {
+    // every open node with a key greater than "key" is complete. Its parent
+    // is the next open node or, if "key" lies between them, a new node
+    // whose handle is "p".
+    std::vector<Component> &stack = stack_;
+    while (stack.back().key > key) {
+      Component c = stack.back();
+      stack.pop_back();
+      levelRoot_[c.handle] = c.maxElement;
+      if (stack.empty() || stack.back().key < key) {
+        stack.push_back(Component{key, p, p});
+        handleParent_[c.handle] = p;
+      }
+      else {
+        handleParent_[c.handle] = stack.back().handle;
+      }
+    }
+  }
+
+  template<class WeightType>
+  template<class KeyFunc>
+  void FloodCTBuilder<WeightType>::relabel(uint32 numberOfKeys, KeyFunc key,
+    std::vector<uint32> &canonical, std::vector<uint32> &R)
+  {
+    // the handle of the node of "p" is "p" itself or its parent.
+    const std::vector<uint32> &parent = handleParent_;
+    const std::vector<uint32> &levelRoot = levelRoot_;
+    const uint32 numberOfElements = parent.size();
+    canonical.resize(numberOfElements);
+    for (uint32 p = 0; p < numberOfElements; p++) {
+      bool isHandle = parent[p] == p || key(parent[p]) != key(p);
+      uint32 h = isHandle ? p : parent[p];
+      if (levelRoot[h] != p)
+        canonical[p] = levelRoot[h];
+      else
+        canonical[p] = parent[h] == h ? p : levelRoot[parent[h]];
+    }
+
+    // R sorted by decreasing key, then by increasing index, from the
+    // histogram of the keys counted for the queue.
+    std::vector<uint32> &offset = counter_;
+    uint32 next = 0;
+    for (uint32 k = numberOfKeys; k > 0; k--) {
+      uint32 count = offset[k-1];
+      offset[k-1] = next;
+      next += count;
+    }
+
+    R.resize(numberOfElements);
+    for (uint32 p = 0; p < numberOfElements; p++)
+      R[offset[key(p)]++] = p;
+  }
+}
\ No newline at end of file
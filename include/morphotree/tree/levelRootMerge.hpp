@@ -0,0 +1,124 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace morphotree
+{
+  // LevelRootMerge merges partial component trees (Wilkinson et al.) over a
+  // parent array in which the elements of a node form a chain of same-level
+  // elements ending at the level root of the node; the root points to
+  // itself. It holds references to the parent array and to the levels of
+  // the elements, and "maxTree" tells whether deeper nodes have greater
+  // levels (max-tree) or smaller ones (min-tree). It is the merge shared by
+  // the builders which build a tree piecewise (ParallelCTBuilder,
+  // TiledTreeBuilder, StreamingCTBuilder) and by TreeUpdater.
+  template<class WeightType>
+  class LevelRootMerge
+  {
+  public:
+    static const uint32 UNDEF;
+
+    LevelRootMerge(std::vector<uint32> &parent, const std::vector<WeightType> &level,
+      bool maxTree);
+
+    // merges the paths from x and y to their roots into a single path
+    // ordered by level, fusing the level roots with the same level.
+    void connect(uint32 x, uint32 y);
+
+    // level root of the node of x. Same-level chains grow with the merges,
+    // so they are halved on the way.
+    inline uint32 levelRoot(uint32 x);
+
+    // level root of the parent node of x, or UNDEF at the root.
+    inline uint32 parentRoot(uint32 x);
+
+    // levelRoot without halving, which leaves the parent array untouched
+    // and can be called from several threads at once.
+    inline uint32 findLevelRoot(uint32 x) const;
+
+    inline bool isDeeper(WeightType a, WeightType b) const { return maxTree_ ? a > b : a < b; }
+
+  private:
+    std::vector<uint32> &parent_;
+    const std::vector<WeightType> &level_;
+    bool maxTree_;
+  };
+
+  // =============== [IMPLEMENTATION] ==================================================
+  template<class WeightType>
+  const uint32 LevelRootMerge<WeightType>::UNDEF = std::numeric_limits<uint32>::max();
+
+  template<class WeightType>
+  LevelRootMerge<WeightType>::LevelRootMerge(std::vector<uint32> &parent,
+    const std::vector<WeightType> &level, bool maxTree)
+    :parent_{parent}, level_{level}, maxTree_{maxTree}
+  {}
+
+  template<class WeightType>
+  void LevelRootMerge<WeightType>::connect(uint32 x, uint32 y)
+  {
+    x = levelRoot(x);
+    y = levelRoot(y);
+    while (x != y) {
+      if (isDeeper(level_[y], level_[x]))
+        std::swap(x, y);
+
+      uint32 px = parentRoot(x);
+      if (level_[x] == level_[y]) {
+        uint32 py = parentRoot(y);
+        parent_[y] = x;
+        if (py == UNDEF)
+          return;
+        if (px == UNDEF) {
+          parent_[x] = py;
+          return;
+        }
+        if (isDeeper(level_[py], level_[px]))
+          parent_[x] = py;
+        x = px;
+        y = py;
+      }
+      else if (px == UNDEF) {
+        parent_[x] = y;
+        return;
+      }
+      else if (isDeeper(level_[y], level_[px])) {
+        parent_[x] = y;
+        x = px;
+      }
+      else {
+        x = px;
+      }
+    }
+  }
+
+  template<class WeightType>
+  uint32 LevelRootMerge<WeightType>::levelRoot(uint32 x)
+  {
+    while (parent_[x] != x && level_[parent_[x]] == level_[x]) {
+      uint32 p = parent_[x];
+      if (parent_[p] != p && level_[parent_[p]] == level_[p])
+        parent_[x] = parent_[p];
+      x = parent_[x];
+    }
+    return x;
+  }
+
+  template<class WeightType>
+  uint32 LevelRootMerge<WeightType>::parentRoot(uint32 x)
+  {
+    return parent_[x] == x ? UNDEF : levelRoot(parent_[x]);
+  }
+
+  template<class WeightType>
+  uint32 LevelRootMerge<WeightType>::findLevelRoot(uint32 x) const
+  {
+    while (parent_[x] != x && level_[parent_[x]] == level_[x])
+      x = parent_[x];
+    return x;
+  }
+}
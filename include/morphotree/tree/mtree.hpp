@@ -2,12 +2,20 @@
 
 #include "morphotree/core/alias.hpp"
 #include "morphotree/core/box.hpp"
+#include "morphotree/core/span.hpp"
+#include "morphotree/core/copyCounter.hpp"
+#include "morphotree/core/indexDispatch.hpp"
 #include <memory>
-#include <list>
 #include <vector>
 #include <limits>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
 
 #include "morphotree/tree/ct_builder.hpp"
+#include "morphotree/tree/parallel_ct_builder.hpp"
+#include "morphotree/tree/concurrent_ct_builder.hpp"
+#include "morphotree/tree/flood_ct_builder.hpp"
 #include "morphotree/adjacency/adjacency.hpp"
 #include "morphotree/core/sort.hpp"
 
@@ -23,536 +31,1287 @@ namespace morphotree
     TreeOfShapes
   };
 
+  // Numbering of the nodes of a MorphologicalTree. Both are top-down
+  // (parent(id) < id). "DepthFirst" numbers the nodes in depth-first
+  // pre-order, so that every subtree is a contiguous range of ids and of
+  // CNPs.
+  enum class NodeOrdering
+  {
+    LevelRoots,
+    DepthFirst
+  };
+
+  // Engine used by buildMaxTree and buildMinTree when more than one thread
+  // is requested: "StripeMerge" (ParallelCTBuilder) builds a tree per stripe
+  // and merges them, "ConcurrentUnionFind" (ConcurrentCTBuilder) shares a
+  // single lock-free union-find between the threads.
+  enum class ParallelEngine
+  {
+    StripeMerge,
+    ConcurrentUnionFind
+  };
+
+  template<class WeightType, class IndexType = uint32>
+  class MorphologicalTree;
+
   template<class WeightType>
+  class TreeUpdater;
+
+  // MTNode is a thin view of a node stored in the flat arrays of a
+  // MorphologicalTree. The nodes live in an arena owned by the tree and
+  // NodePtr is a plain non-owning pointer into it: it is valid as long as
+  // the tree it comes from is alive, and copying it never touches a
+  // reference count.
+  template<class WeightType, class IndexType = uint32>
   class MTNode
   {
   public:
-    using ValueType = WeightType; 
-    using NodePtr = std::shared_ptr<MTNode<WeightType>>;
+    using ValueType = WeightType;
+    using NodePtr = MTNode<WeightType, IndexType>*;
+    using TreeType = MorphologicalTree<WeightType, IndexType>;
+
+    class ChildIterator
+    {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = NodePtr;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const NodePtr*;
+      using reference = NodePtr;
+
+      ChildIterator(const TreeType *tree, const IndexType *child);
+
+      inline NodePtr operator*() const { return tree_->node(*child_); }
+      inline ChildIterator& operator++() { child_++; return *this; }
+      inline bool operator==(const ChildIterator &other) const { return child_ == other.child_; }
+      inline bool operator!=(const ChildIterator &other) const { return child_ != other.child_; }
+
+    private:
+      const TreeType *tree_;
+      const IndexType *child_;
+    };
+
+    class ChildrenRange
+    {
+    public:
+      ChildrenRange(const TreeType *tree, Span<const IndexType> ids);
+
+      inline ChildIterator begin() const { return ChildIterator{tree_, ids_.begin()}; }
+      inline ChildIterator end() const { return ChildIterator{tree_, ids_.end()}; }
+      inline IndexType size() const { return ids_.size(); }
+      inline bool empty() const { return ids_.empty(); }
+      inline Span<const IndexType> ids() const { return ids_; }
+
+    private:
+      const TreeType *tree_;
+      Span<const IndexType> ids_;
+    };
 
-    MTNode(uint32 id=0);
+    MTNode(TreeType *tree=nullptr, IndexType id=0);
 
-    inline uint32 id() const { return id_; }
-    inline uint32& id() { return id_; }
-    inline void id(uint32 newid) { id_ = newid; } 
+    inline IndexType id() const { return id_; }
 
-    inline uint32 representative() const { return representative_; }
-    inline uint32& representative() { return representative_; } 
-    inline void representative(uint32 newrep) { representative_ = newrep; }
+    inline IndexType representative() const;
+    inline void representative(IndexType newrep);
 
-    inline WeightType& level() { return level_; }
-    inline WeightType  level() const { return level_; }
-    inline void level(WeightType v) { level_ = v; }
+    inline WeightType& level();
+    inline WeightType  level() const;
+    inline void level(WeightType v);
 
-    inline const std::vector<uint32>& cnps() const { return cnps_; }
-    inline void appendCNP(uint32 cnp) { cnps_.push_back(cnp); }
-    inline void includeCNPS(const std::vector<uint32> &cnps);
+    inline Span<const IndexType> cnps() const;
 
-    inline NodePtr parent() { return parent_; }
-    inline const NodePtr parent() const  { return parent_; }
-    inline void parent(NodePtr parent) { parent_ = parent;}
+    NodePtr parent() const;
+    ChildrenRange children() const;
 
-    inline void appendChild(std::shared_ptr<MTNode> child) { children_.push_back(child); }
-    inline void includeChildren(const std::vector<NodePtr> &children);
-    inline void removeChild(NodePtr c) { children_.remove(c); }
-    inline const std::list<NodePtr>& children() const { return children_; }
-    
-    std::vector<uint32> reconstruct() const;
+    std::vector<IndexType> reconstruct() const;
     std::vector<bool> reconstruct(const Box &domain) const;
 
-    std::vector<WeightType> reconstructGrey(const Box &domain, 
+    std::vector<WeightType> reconstructGrey(const Box &domain,
       WeightType backgroundValue=0) const;
 
-    NodePtr copy() const;
-
-  private:
-    void reconstruct(std::vector<uint32> &pixels, const NodePtr node) const; 
-    void reconstructGrey(NodePtr node, const Box &domain, 
-      std::vector<WeightType> &f) const;
+    friend class MorphologicalTree<WeightType, IndexType>;
 
   private:
-    uint32 id_;
-    uint32 representative_;
-
-    WeightType level_;
-    std::vector<uint32> cnps_;
-    NodePtr parent_;
-    std::list<NodePtr> children_;
+    TreeType *tree_;
+    IndexType id_;
   };
 
-  template<class WeightType>
+  // MorphologicalTree stores the tree as flat arrays indexed by node id:
+  // "parent", "level" and "representative", plus the children and the
+  // CNPs of every node in compressed-sparse-row form ("childOffset" and
+  // "children", "cnpOffset" and "cnps").
+  // Node ids are in top-down order, i.e., parent(id) < id for every
+  // non-root node, and the root has id 0. After renumberDepthFirst(), the
+  // subtree of "id" is the id range [id, id + subtreeSize(id)) and the
+  // tree caches the depth and subtree size of every node and its leaves.
+  // Node ids and pixel indices are stored as IndexType (uint32 by
+  // default; uint16 halves the arrays of trees of small images), which
+  // must hold the number of pixels: its largest value is UndefinedIndex.
+  template<class WeightType, class IndexType>
   class MorphologicalTree
   {
+    static_assert(std::is_same<IndexType, uint16>::value || std::is_same<IndexType, uint32>::value,
+      "MorphologicalTree supports uint16 and uint32 indices only");
+
   public:
-    using NodePtr = typename MTNode<WeightType>::NodePtr; 
-    using NodeType = MTNode<WeightType>;
+    using NodePtr = typename MTNode<WeightType, IndexType>::NodePtr;
+    using NodeType = MTNode<WeightType, IndexType>;
     using TreeWeightType = WeightType;
 
-    MorphologicalTree(MorphoTreeType type, const std::vector<WeightType> &f, const CTBuilderResult &res);
-    MorphologicalTree(MorphoTreeType type, std::vector<uint32> &&cmap, std::vector<NodePtr> &&nodes);
+    MorphologicalTree(MorphoTreeType type, const std::vector<WeightType> &f,
+      const BasicCTBuilderResult<IndexType> &res);
+    MorphologicalTree(MorphoTreeType type, const std::vector<WeightType> &f,
+      const std::vector<IndexType> &parent, const std::vector<IndexType> &R);
+    MorphologicalTree(MorphoTreeType type, std::vector<IndexType> &&cmap, std::vector<IndexType> &&parent,
+      std::vector<WeightType> &&level, std::vector<IndexType> &&representative);
     MorphologicalTree(MorphoTreeType type);
 
-    const NodePtr node(uint32 id) const { return nodes_[id]; }
-    NodePtr node(uint32 id) { return nodes_[id]; }
-    
-    const NodePtr root() const { return root_; }
-    NodePtr root() { return root_; }
-
-    inline std::vector<uint32> reconstructNode(uint32 nodeId) const { return nodes_[nodeId]->reconstruct(); }
-    std::vector<bool> reconstructNode(uint32 nodeId, const Box &domain) const { return nodes_[nodeId]->reconstruct(domain); };
-
-    std::vector<uint32> reconstructNodes(std::function<bool(NodePtr)> keep) const;
+    MorphologicalTree(const MorphologicalTree<WeightType, IndexType> &other);
+    MorphologicalTree(MorphologicalTree<WeightType, IndexType> &&other);
+    MorphologicalTree<WeightType, IndexType>& operator=(const MorphologicalTree<WeightType, IndexType> &other);
+    MorphologicalTree<WeightType, IndexType>& operator=(MorphologicalTree<WeightType, IndexType> &&other);
+
+    // rebuild the tree in place from the parent array and order R of a
+    // CTBuilder, reusing the storage of the tree: a tree rebuilt with the
+    // same number of pixels allocates only when it has more nodes than
+    // ever before.
+    void assign(MorphoTreeType type, const std::vector<WeightType> &f,
+      const std::vector<IndexType> &parent, const std::vector<IndexType> &R);
+
+    // rebuild the tree in place from a node description, as the
+    // constructor taking rvalues. The arrays are swapped with the ones of
+    // the tree, so the arguments get back the previous storage of the tree
+    // to be filled again.
+    void swapAssign(MorphoTreeType type, std::vector<IndexType> &cmap, std::vector<IndexType> &parent,
+      std::vector<WeightType> &level, std::vector<IndexType> &representative);
+
+    const NodePtr node(IndexType id) const;
+    NodePtr node(IndexType id);
+
+    const NodePtr root() const { return nodes_.empty() ? nullptr : node(0); }
+    NodePtr root() { return nodes_.empty() ? nullptr : node(0); }
+
+    // index-based access to the flat representation.
+    inline IndexType parent(IndexType nodeId) const { return parent_[nodeId]; }
+    inline WeightType level(IndexType nodeId) const { return level_[nodeId]; }
+    inline IndexType representative(IndexType nodeId) const { return representative_[nodeId]; }
+    inline Span<const IndexType> children(IndexType nodeId) const;
+    inline IndexType numberOfChildren(IndexType nodeId) const { return childOffset_[nodeId+1] - childOffset_[nodeId]; }
+    inline Span<const IndexType> cnps(IndexType nodeId) const;
+    inline IndexType numberOfCNPs(IndexType nodeId) const { return cnpOffset_[nodeId+1] - cnpOffset_[nodeId]; }
+
+    inline const std::vector<IndexType>& parents() const { return parent_; }
+    inline const std::vector<WeightType>& levels() const { return level_; }
+    inline const std::vector<IndexType>& representatives() const { return representative_; }
+    inline const std::vector<IndexType>& cmap() const { return cmap_; }
+    inline const std::vector<IndexType>& childOffsets() const { return childOffset_; }
+    inline const std::vector<IndexType>& packedChildren() const { return children_; }
+    inline const std::vector<IndexType>& cnpOffsets() const { return cnpOffset_; }
+    inline const std::vector<IndexType>& packedCNPs() const { return cnps_; }
+
+    inline std::vector<IndexType> reconstructNode(IndexType nodeId) const { return nodes_[nodeId].reconstruct(); }
+    std::vector<bool> reconstructNode(IndexType nodeId, const Box &domain) const { return nodes_[nodeId].reconstruct(domain); };
+
+    std::vector<IndexType> reconstructNodes(std::function<bool(NodePtr)> keep) const;
     std::vector<bool> reconstructNodes(std::function<bool(NodePtr)> keep, const Box &domain) const;
 
-    uint32 numberOfNodes() const { return nodes_.size(); }
+    IndexType numberOfNodes() const { return nodes_.size(); }
 
-    uint32 numberOfCNPs() const { return cmap_.size(); }
+    IndexType numberOfCNPs() const { return cmap_.size(); }
 
     void tranverse(std::function<void(const NodePtr node)> visit) const;
 
+    // Inlinable traversals. "visit" is called with a NodePtr.
+    // forEachPostOrder visits every node after all of its descendants,
+    // forEachBFS visits the nodes level by level from the root, and
+    // forEachPreOrder visits every node before its descendants: there
+    // "visit" returns false to skip the subtree of the node.
+    template<class Visitor>
+    void forEachPostOrder(Visitor &&visit) const;
+
+    template<class Visitor>
+    void forEachPreOrder(Visitor &&visit) const;
+
+    template<class Visitor>
+    void forEachBFS(Visitor &&visit) const;
+
     std::vector<WeightType> reconstructImage() const;
     std::vector<WeightType> reconstructImage(std::function<bool(const NodePtr)> keep) const;
 
+    // Reconstruction of the image filtered by a keep mask indexed by node
+    // id, without building the filtered tree. The root is always kept.
+    std::vector<WeightType> reconstructImage(const std::vector<bool> &keep) const;
+    void reconstructImage(const std::vector<bool> &keep, std::vector<WeightType> &f) const;
+
     void idirectFilter(std::function<bool(const NodePtr)> keep);
 
-    MorphologicalTree<WeightType> directFilter(std::function<bool(const NodePtr)> keep) const;    
+    MorphologicalTree<WeightType, IndexType> directFilter(std::function<bool(const NodePtr)> keep) const;
+
+    // Direct filter driven by a keep mask indexed by node id (the root is
+    // always kept). "newId" receives the id of every kept node in the
+    // filtered tree and UndefinedIndex for the removed ones.
+    void idirectFilter(const std::vector<bool> &keep);
+    void idirectFilter(const std::vector<bool> &keep, std::vector<IndexType> &newId);
+
+    MorphologicalTree<WeightType, IndexType> directFilter(const std::vector<bool> &keep) const;
+    MorphologicalTree<WeightType, IndexType> directFilter(const std::vector<bool> &keep, 
+      std::vector<IndexType> &newId) const;
 
     void traverseByLevel(std::function<void(const NodePtr)> visit) const;
 
     void traverseByLevel(std::function<void(NodePtr)> visit);
 
-    inline NodePtr smallComponent(uint32 idx) { return nodes_[cmap_[idx]]; }    
-    inline const NodePtr smallComponent(uint32 idx) const { return nodes_[cmap_[idx]]; }
-    
-    NodePtr smallComponent(uint32 idx, const std::vector<bool> &mask);
-    const NodePtr smallComponent(uint32 idx, const std::vector<bool> &mask) const;
+    inline NodePtr smallComponent(IndexType idx) { return node(cmap_[idx]); }
+    inline const NodePtr smallComponent(IndexType idx) const { return node(cmap_[idx]); }
+
+    NodePtr smallComponent(IndexType idx, const std::vector<bool> &mask);
+    const NodePtr smallComponent(IndexType idx, const std::vector<bool> &mask) const;
+
+    // id of smallComponent(idx, mask) for every pixel, in one linear pass.
+    std::vector<IndexType> smallComponents(const std::vector<bool> &mask) const;
 
-    MorphologicalTree<WeightType> copy() const;
+    MorphologicalTree<WeightType, IndexType> copy() const;
 
     inline MorphoTreeType type() const { return type_; }
 
-    static const uint32 UndefinedIndex;
+    void renumberDepthFirst();
+    inline bool isDepthFirst() const { return depthFirst_; }
+
+    // only available for depth-first numbered trees.
+    inline IndexType depth(IndexType nodeId) const { return depth_[nodeId]; }
+    inline IndexType subtreeSize(IndexType nodeId) const { return subtreeSize_[nodeId]; }
+    inline const std::vector<IndexType>& depths() const { return depth_; }
+    inline const std::vector<IndexType>& subtreeSizes() const { return subtreeSize_; }
+    inline const std::vector<IndexType>& leaves() const { return leaves_; }
+    inline Span<const IndexType> subtreeCNPs(IndexType nodeId) const;
+
+    bool isDescendant(IndexType nodeId, IndexType ancestorId) const;
+
+    static const IndexType UndefinedIndex;
+
+    friend class MTNode<WeightType, IndexType>;
+
+    // TreeUpdater rewrites in place the entries of the nodes it updates.
+    template<class> friend class TreeUpdater;
 
   private:
-    void performDirectFilter(MorphologicalTree<WeightType> &tree, std::function<bool(const NodePtr)> keep) const;
-    
+    void createNodes();
+    void computeChildren();
+    void computeCNPs();
+    void bindNodes();
+    void computeDepthFirstCaches();
+    std::vector<bool> keepMask(std::function<bool(const NodePtr)> keep) const;
+    void performDirectFilter(MorphologicalTree<WeightType, IndexType> &tree, const std::vector<bool> &keep,
+      std::vector<IndexType> &newId) const;
+
   private:
-    std::vector<NodePtr> nodes_;
-    std::vector<uint32> cmap_;
-    NodePtr root_;
+    std::vector<IndexType> parent_;
+    std::vector<WeightType> level_;
+    std::vector<IndexType> representative_;
+    std::vector<IndexType> childOffset_;
+    std::vector<IndexType> children_;
+    std::vector<IndexType> cnpOffset_;
+    std::vector<IndexType> cnps_;
+    std::vector<NodeType> nodes_;
+    std::vector<IndexType> cmap_;
     MorphoTreeType type_;
+    bool depthFirst_;
+    std::vector<IndexType> depth_;
+    std::vector<IndexType> subtreeSize_;
+    std::vector<IndexType> leaves_;
+  };
+
+  // IndexType is the index type of the tree, uint32 by default. Trees with
+  // another index type are built by a CTBuilder of that type and throw for
+  // "numberOfThreads" > 1; "f" must not have more pixels than IndexType
+  // (nor uint32) holds.
+  template<class WeightType, class IndexType = uint32>
+  MorphologicalTree<WeightType, IndexType> buildMaxTree(const std::vector<WeightType> &f,
+    std::shared_ptr<Adjacency> adj, NodeOrdering ordering = NodeOrdering::LevelRoots,
+    uint32 numberOfThreads = 1, ParallelEngine engine = ParallelEngine::StripeMerge);
+
+  template<class WeightType, class IndexType = uint32>
+  MorphologicalTree<WeightType, IndexType> buildMinTree(const std::vector<WeightType> &f,
+    std::shared_ptr<Adjacency> adj, NodeOrdering ordering = NodeOrdering::LevelRoots,
+    uint32 numberOfThreads = 1, ParallelEngine engine = ParallelEngine::StripeMerge);
+
+  // build the max-tree (min-tree) of "f" with the narrowest index type which
+  // holds its pixels (see withNarrowestIndex) and return "visit" called
+  // with the tree, e.g. a uint16 tree for a 64x64 patch. "visit" is a
+  // generic lambda returning the same type for every index type. Images
+  // with more pixels than uint32 holds throw (see withNarrowestIndex).
+  template<class WeightType, class Visitor>
+  auto withNarrowestMaxTree(const std::vector<WeightType> &f, std::shared_ptr<Adjacency> adj,
+    Visitor &&visit, NodeOrdering ordering = NodeOrdering::LevelRoots);
+
+  template<class WeightType, class Visitor>
+  auto withNarrowestMinTree(const std::vector<WeightType> &f, std::shared_ptr<Adjacency> adj,
+    Visitor &&visit, NodeOrdering ordering = NodeOrdering::LevelRoots);
+
+  template<class WeightType>
+  struct MaxAndMinTrees
+  {
+    MorphologicalTree<WeightType> maxTree;
+    MorphologicalTree<WeightType> minTree;
   };
 
-  template<class WeightType> 
-  MorphologicalTree<WeightType> buildMaxTree(const std::vector<WeightType> &f,
-    std::shared_ptr<Adjacency> adj);
+  // max-tree and min-tree of "f" from a single sort: the order of the
+  // min-tree is the one of the max-tree with its levels reversed
+  // (reverseLevelOrder). With one thread, both union-find passes share the
+  // buffers of a single CTBuilder; with "numberOfThreads" > 1, the sort is
+  // split between the threads and the two passes run concurrently. Low
+  // bit-depth images are flooded twice instead, which needs no sort. The
+  // trees are the same as those of buildMaxTree and buildMinTree.
+  template<class WeightType>
+  MaxAndMinTrees<WeightType> buildMaxAndMinTrees(const std::vector<WeightType> &f,
+    std::shared_ptr<Adjacency> adj, NodeOrdering ordering = NodeOrdering::LevelRoots,
+    uint32 numberOfThreads = 1);
 
+  // component tree of "f" processed in the order "R" with the builder
+  // selected by "numberOfThreads" and "engine". R is moved into the result.
   template<class WeightType>
-  MorphologicalTree<WeightType> buildMinTree(const std::vector<WeightType> &f,
-    std::shared_ptr<Adjacency> adj);
+  CTBuilderResult buildComponentTree(const std::vector<WeightType> &f,
+    std::shared_ptr<Adjacency> adj, std::vector<uint32> R, uint32 numberOfThreads,
+    ParallelEngine engine);
+
+  // component tree of buildMaxTree ("maxTree" true) or buildMinTree with
+  // the indices of "tag": uint32 trees are built by the builder selected
+  // by "numberOfThreads" and "engine" (or flooded, for low bit-depth
+  // images), the other ones by a single-threaded CTBuilder of their index
+  // type, which throws for "numberOfThreads" > 1.
+  template<class WeightType>
+  CTBuilderResult buildComponentTree(IndexTag<uint32>, const std::vector<WeightType> &f,
+    std::shared_ptr<Adjacency> adj, bool maxTree, uint32 numberOfThreads, ParallelEngine engine);
 
+  template<class WeightType, class IndexType>
+  BasicCTBuilderResult<IndexType> buildComponentTree(IndexTag<IndexType>,
+    const std::vector<WeightType> &f, std::shared_ptr<Adjacency> adj, bool maxTree,
+    uint32 numberOfThreads, ParallelEngine);
 
   // ======================[ IMPLEMENTATION ] ===================================================================
-  template<typename WeightType>
-  const uint32 MorphologicalTree<WeightType>::UndefinedIndex = std::numeric_limits<uint32>::max();
+  template<class WeightType, class IndexType>
+  const IndexType MorphologicalTree<WeightType, IndexType>::UndefinedIndex = std::numeric_limits<IndexType>::max();
 
-  template<class WeightType>
-  MTNode<WeightType>::MTNode(uint32 id)
-    :id_{id}, level_{0}, parent_{nullptr}
+  template<class WeightType, class IndexType>
+  MTNode<WeightType, IndexType>::ChildIterator::ChildIterator(const TreeType *tree, const IndexType *child)
+    :tree_{tree}, child_{child}
   {}
 
-  template<class WeightType>
-  std::vector<uint32> MTNode<WeightType>::reconstruct() const
+  template<class WeightType, class IndexType>
+  MTNode<WeightType, IndexType>::ChildrenRange::ChildrenRange(const TreeType *tree, Span<const IndexType> ids)
+    :tree_{tree}, ids_{ids}
+  {}
+
+  template<class WeightType, class IndexType>
+  MTNode<WeightType, IndexType>::MTNode(TreeType *tree, IndexType id)
+    :tree_{tree}, id_{id}
+  {}
+
+  template<class WeightType, class IndexType>
+  IndexType MTNode<WeightType, IndexType>::representative() const
   {
-    std::vector<uint32> pixels{cnps_};
-    for (NodePtr child : children_) {
-      reconstruct(pixels, child);
-    }
-    return pixels;
+    return tree_->representative_[id_];
   }
 
-  template<class WeightType>
-  void MTNode<WeightType>::reconstruct(std::vector<uint32> &pixels, const NodePtr node) const
+  template<class WeightType, class IndexType>
+  void MTNode<WeightType, IndexType>::representative(IndexType newrep)
+  {
+    tree_->representative_[id_] = newrep;
+  }
+
+  template<class WeightType, class IndexType>
+  WeightType& MTNode<WeightType, IndexType>::level()
+  {
+    return tree_->level_[id_];
+  }
+
+  template<class WeightType, class IndexType>
+  WeightType MTNode<WeightType, IndexType>::level() const
+  {
+    return tree_->level_[id_];
+  }
+
+  template<class WeightType, class IndexType>
+  void MTNode<WeightType, IndexType>::level(WeightType v)
+  {
+    tree_->level_[id_] = v;
+  }
+
+  template<class WeightType, class IndexType>
+  Span<const IndexType> MTNode<WeightType, IndexType>::cnps() const
+  {
+    return tree_->cnps(id_);
+  }
+
+  template<class WeightType, class IndexType>
+  typename MTNode<WeightType, IndexType>::NodePtr MTNode<WeightType, IndexType>::parent() const
   {
-    pixels.insert(pixels.end(), node->cnps().begin(), node->cnps().end());
-    for (NodePtr child: node->children()) {
-      reconstruct(pixels, child);
+    IndexType pid = tree_->parent_[id_];
+    if (pid == TreeType::UndefinedIndex)
+      return nullptr;
+    return tree_->node(pid);
+  }
+
+  template<class WeightType, class IndexType>
+  typename MTNode<WeightType, IndexType>::ChildrenRange MTNode<WeightType, IndexType>::children() const
+  {
+    return ChildrenRange{tree_, tree_->children(id_)};
+  }
+
+  template<class WeightType, class IndexType>
+  std::vector<IndexType> MTNode<WeightType, IndexType>::reconstruct() const
+  {
+    if (tree_->depthFirst_) 
+      return tree_->subtreeCNPs(id_);
+
+    std::vector<IndexType> pixels;
+    std::stack<IndexType> s;
+    s.push(id_);
+
+    while (!s.empty()) {
+      IndexType nid = s.top();
+      s.pop();
+
+      Span<const IndexType> cnps = tree_->cnps(nid);
+      pixels.insert(pixels.end(), cnps.begin(), cnps.end());
+      Span<const IndexType> children = tree_->children(nid);
+      for (auto it = children.end(); it != children.begin(); )
+        s.push(*(--it));
     }
+    return pixels;
   }
 
-  template<class WeightType>
-  std::vector<bool> MTNode<WeightType>::reconstruct(const Box &domain) const
+  template<class WeightType, class IndexType>
+  std::vector<bool> MTNode<WeightType, IndexType>::reconstruct(const Box &domain) const
   {
-    std::vector<uint32> indices = reconstruct();
+    std::vector<IndexType> indices = reconstruct();
     std::vector<bool> img(domain.numberOfPoints(), false);
-    for (uint32 i : indices) {
+    for (IndexType i : indices) {
       img[i] = true;
     }
     return img;
   }
 
-  template<class WeightType>
-  std::vector<WeightType>  MTNode<WeightType>::reconstructGrey(const Box &domain,
+  template<class WeightType, class IndexType>
+  std::vector<WeightType>  MTNode<WeightType, IndexType>::reconstructGrey(const Box &domain,
     WeightType backgroundValue) const
   {
     std::vector<WeightType> f(domain.numberOfPoints(), backgroundValue);
-    
-    for (uint32 p : cnps()) {
-      f[p] = level();
-    }
-    for (NodePtr child :children()) {
-      reconstructGrey(child, domain, f);
+    std::stack<IndexType> s;
+    s.push(id_);
+
+    while (!s.empty()) {
+      IndexType nid = s.top();
+      s.pop();
+
+      WeightType level = tree_->level_[nid];
+      for (IndexType p : tree_->cnps(nid)) {
+        f[p] = level;
+      }
+      for (IndexType c : tree_->children(nid)) {
+        s.push(c);
+      }
     }
-    
+
     return f;
   }
 
-  template<class WeightType>
-  void MTNode<WeightType>::reconstructGrey(NodePtr node, const Box &domain, 
-    std::vector<WeightType> &f) const
+  // ========================== [TREEE] =========================================================================
+  template<class WeightType, class IndexType>
+  MorphologicalTree<WeightType, IndexType>::MorphologicalTree(MorphoTreeType type)
+    :type_{type}, depthFirst_{false}
+  { }
+
+  template<class WeightType, class IndexType>
+  MorphologicalTree<WeightType, IndexType>::MorphologicalTree(MorphoTreeType type,
+    std::vector<IndexType> &&cmap, std::vector<IndexType> &&parent,
+    std::vector<WeightType> &&level, std::vector<IndexType> &&representative)
+    :parent_{std::move(parent)}, level_{std::move(level)},
+     representative_{std::move(representative)}, cmap_{std::move(cmap)}, type_{type},
+     depthFirst_{false}
+  {
+    createNodes();
+    computeCNPs();
+  }
+
+  template<class WeightType, class IndexType>
+  MorphologicalTree<WeightType, IndexType>::MorphologicalTree(MorphoTreeType type,
+    const std::vector<WeightType> &f,  const BasicCTBuilderResult<IndexType> &res)
+    :type_{type}, depthFirst_{false}
+  {
+    assign(type, f, res.parent, res.R);
+  }
+
+  template<class WeightType, class IndexType>
+  MorphologicalTree<WeightType, IndexType>::MorphologicalTree(MorphoTreeType type,
+    const std::vector<WeightType> &f, const std::vector<IndexType> &parent,
+    const std::vector<IndexType> &R)
+    :type_{type}, depthFirst_{false}
+  {
+    assign(type, f, parent, R);
+  }
+
+  template<class WeightType, class IndexType>
+  void MorphologicalTree<WeightType, IndexType>::assign(MorphoTreeType type,
+    const std::vector<WeightType> &f, const std::vector<IndexType> &parent,
+    const std::vector<IndexType> &R)
   {
-    for (uint32 p : node->cnps()) {
-      f[p] = node->level();
+    const IndexType UNDEF = std::numeric_limits<IndexType>::max();
+    type_ = type;
+    depthFirst_ = false;
+    depth_.clear();
+    subtreeSize_.clear();
+    leaves_.clear();
+    cmap_.assign(f.size(), UNDEF);
+
+    IndexType numberOfNodes = 0;
+    for (IndexType p : R) {
+      if (f[parent[p]] != f[p] || parent[p] == p)
+        numberOfNodes++;
     }
-    for (NodePtr c : node->children()) {
-      reconstructGrey(c, domain, f);
+
+    parent_.resize(numberOfNodes);
+    level_.resize(numberOfNodes);
+    representative_.resize(numberOfNodes);
+
+    // Level roots are visited from the root to the leaves, so that
+    // parent(id) < id.
+    IndexType id = 0;
+    for (IndexType i = R.size(); i > 0; i--) {
+      IndexType p = R[i - 1];
+      if (f[parent[p]] == f[p] && parent[p] != p)
+        continue;
+      cmap_[p] = id;
+      parent_[id] = id == 0 ? UndefinedIndex : cmap_[parent[p]];
+      level_[id] = f[p];
+      representative_[id] = p;
+      id++;
     }
+
+    for (IndexType i = 0; i < f.size(); i++) {
+      if (cmap_[i] == UNDEF) 
+        cmap_[i] = cmap_[parent[i]];
+    }
+
+    createNodes();
+    computeCNPs();
   }
 
-  template<class WeightType>
-  void MTNode<WeightType>::includeCNPS(const std::vector<uint32>& cnps)
+  template<class WeightType, class IndexType>
+  void MorphologicalTree<WeightType, IndexType>::swapAssign(MorphoTreeType type,
+    std::vector<IndexType> &cmap, std::vector<IndexType> &parent,
+    std::vector<WeightType> &level, std::vector<IndexType> &representative)
   {
-    cnps_.insert(cnps_.end(), cnps.begin(), cnps.end());
+    type_ = type;
+    depthFirst_ = false;
+    depth_.clear();
+    subtreeSize_.clear();
+    leaves_.clear();
+    cmap_.swap(cmap);
+    parent_.swap(parent);
+    level_.swap(level);
+    representative_.swap(representative);
+    createNodes();
+    computeCNPs();
   }
 
-  template<class WeightType>
-  void MTNode<WeightType>::includeChildren(const std::vector<NodePtr> &children)
+  template<class WeightType, class IndexType>
+  MorphologicalTree<WeightType, IndexType>::MorphologicalTree(const MorphologicalTree<WeightType, IndexType> &other)
+    :parent_{other.parent_}, level_{other.level_}, representative_{other.representative_},
+     childOffset_{other.childOffset_}, children_{other.children_}, cnpOffset_{other.cnpOffset_},
+     cnps_{other.cnps_}, nodes_{other.nodes_},
+     cmap_{other.cmap_}, type_{other.type_}, depthFirst_{other.depthFirst_},
+     depth_{other.depth_}, subtreeSize_{other.subtreeSize_}, leaves_{other.leaves_}
   {
-    children_.insert(children_.end(), children.begin(), children.end());
+    CopyCounter::increment();
+    bindNodes();
   }
 
-  template<class WeightType>
-  typename MTNode<WeightType>::NodePtr MTNode<WeightType>::copy() const
+  template<class WeightType, class IndexType>
+  MorphologicalTree<WeightType, IndexType>::MorphologicalTree(MorphologicalTree<WeightType, IndexType> &&other)
+    :parent_{std::move(other.parent_)}, level_{std::move(other.level_)},
+     representative_{std::move(other.representative_)}, childOffset_{std::move(other.childOffset_)},
+     children_{std::move(other.children_)}, cnpOffset_{std::move(other.cnpOffset_)},
+     cnps_{std::move(other.cnps_)}, nodes_{std::move(other.nodes_)},
+     cmap_{std::move(other.cmap_)}, type_{other.type_}, depthFirst_{other.depthFirst_},
+     depth_{std::move(other.depth_)}, subtreeSize_{std::move(other.subtreeSize_)},
+     leaves_{std::move(other.leaves_)}
   {
-    NodePtr cnode = std::make_shared<MTNode<WeightType>>(id_);
-    cnode->level(level_);  
-    cnode->cnps_ = cnps_;
-    cnode->representative_ = representative_;
-    return cnode;
+    bindNodes();
   }
 
-  // ========================== [TREEE] =========================================================================
-  template<class WeightType>
-  MorphologicalTree<WeightType>::MorphologicalTree(MorphoTreeType type)
-    :type_{type}
-  { }
+  template<class WeightType, class IndexType>
+  MorphologicalTree<WeightType, IndexType>& MorphologicalTree<WeightType, IndexType>::operator=(
+    const MorphologicalTree<WeightType, IndexType> &other)
+  {
+    if (this != &other) {
+      parent_ = other.parent_;
+      level_ = other.level_;
+      representative_ = other.representative_;
+      childOffset_ = other.childOffset_;
+      children_ = other.children_;
+      cnpOffset_ = other.cnpOffset_;
+      cnps_ = other.cnps_;
+      nodes_ = other.nodes_;
+      cmap_ = other.cmap_;
+      type_ = other.type_;
+      depthFirst_ = other.depthFirst_;
+      depth_ = other.depth_;
+      subtreeSize_ = other.subtreeSize_;
+      leaves_ = other.leaves_;
+      CopyCounter::increment();
+      bindNodes();
+    }
+    return *this;
+  }
 
-  template<class WeightType>
-  MorphologicalTree<WeightType>::MorphologicalTree(MorphoTreeType type, 
-    std::vector<uint32> &&cmap, std::vector<NodePtr> &&nodes)
-    :cmap_{cmap}, nodes_{nodes}, type_{type}
+  template<class WeightType, class IndexType>
+  MorphologicalTree<WeightType, IndexType>& MorphologicalTree<WeightType, IndexType>::operator=(
+    MorphologicalTree<WeightType, IndexType> &&other)
   {
-    root_ = nodes_[0];
+    if (this != &other) {
+      parent_ = std::move(other.parent_);
+      level_ = std::move(other.level_);
+      representative_ = std::move(other.representative_);
+      childOffset_ = std::move(other.childOffset_);
+      children_ = std::move(other.children_);
+      cnpOffset_ = std::move(other.cnpOffset_);
+      cnps_ = std::move(other.cnps_);
+      nodes_ = std::move(other.nodes_);
+      cmap_ = std::move(other.cmap_);
+      type_ = other.type_;
+      depthFirst_ = other.depthFirst_;
+      depth_ = std::move(other.depth_);
+      subtreeSize_ = std::move(other.subtreeSize_);
+      leaves_ = std::move(other.leaves_);
+      bindNodes();
+    }
+    return *this;
   }
 
-  template<class WeightType>
-  MorphologicalTree<WeightType>::MorphologicalTree(MorphoTreeType type, 
-    const std::vector<WeightType> &f,  const CTBuilderResult &res)
-    :type_{type}
-  {
-    const uint32 UNDEF = std::numeric_limits<uint32>::max();
-    std::vector<uint32> sortedLevelRoots;
-    cmap_.resize(f.size(), UNDEF);
-
-    for (uint32 i = 0; i < res.R.size(); i++) {
-      uint32 p = res.R[i];
-      if (f[res.parent[p]] != f[p] || res.parent[p] == p)
-        sortedLevelRoots.push_back(p);
-    }
-
-    nodes_.resize(sortedLevelRoots.size(), nullptr);
-
-    uint32 p = sortedLevelRoots[sortedLevelRoots.size()-1];
-    NodePtr root = std::make_shared<NodeType>(0);
-    root->level(f[p]);
-    root->appendCNP(p);
-    root->representative(p);
-    root->parent(nullptr);
-    cmap_[p] = root->id();
-    nodes_[0] = root;
-    root_ = root;
-
-    
-    for (uint32 i = 2; i <= sortedLevelRoots.size(); i++) {
-      uint32 p = sortedLevelRoots[sortedLevelRoots.size()-i];
-      cmap_[p] = i-1; 
-      
-      NodePtr node = std::make_shared<NodeType>(i-1);
-      NodePtr parentNode = nodes_[cmap_[res.parent[p]]]; 
-      node->id(i-1);
-      node->parent(parentNode);
-      node->level(f[p]);
-      node->appendCNP(p);
-      node->representative(p);
-      parentNode->appendChild(node);
-
-      nodes_[i-1] = node; 
-      
-    }
-
-    for (uint32 i = 0; i < f.size(); i++) {
-      if (cmap_[i] == UNDEF) {
-        cmap_[i] = cmap_[res.parent[i]];
-        nodes_[cmap_[i]]->appendCNP(i);
-      }
+  template<class WeightType, class IndexType>
+  void MorphologicalTree<WeightType, IndexType>::createNodes()
+  {
+    nodes_.clear();
+    nodes_.reserve(parent_.size());
+    for (IndexType id = 0; id < parent_.size(); id++) {
+      nodes_.emplace_back(this, id);
     }
+    computeChildren();
   }
 
-  template<typename WeightType>
-  std::vector<uint32> 
-  MorphologicalTree<WeightType>::reconstructNodes(std::function<bool(NodePtr)> keep) const
+  template<class WeightType, class IndexType>
+  void MorphologicalTree<WeightType, IndexType>::computeChildren()
   {
-    std::vector<uint32> rec;
-    
-    std::stack<NodePtr> s;
-    s.push(root_);
+    const IndexType numberOfNodes = parent_.size();
+    childOffset_.assign(numberOfNodes + 1, 0);
+    for (IndexType id = 0; id < numberOfNodes; id++) {
+      if (parent_[id] != UndefinedIndex)
+        childOffset_[parent_[id] + 1]++;
+    }
 
-    while (!s.empty()) {
-      NodePtr n = s.top();
-      s.pop();
+    for (IndexType id = 1; id <= numberOfNodes; id++) {
+      childOffset_[id] += childOffset_[id - 1];
+    }
 
-      if ((n->id() != root_->id()) && keep(n)) {
-        std::vector<uint32> recn = n->reconstruct();
-        rec.insert(rec.end(), recn.begin(), recn.end());
-      }
-      else {
-        for (NodePtr c : n->children()) 
-          s.push(c);
-      }
+    // childOffset_[id] serves as the insertion point of the children of
+    // "id", which leaves it at the offset of "id" + 1: it is shifted back.
+    children_.resize(childOffset_[numberOfNodes]);
+    for (IndexType id = 0; id < numberOfNodes; id++) {
+      if (parent_[id] != UndefinedIndex)
+        children_[childOffset_[parent_[id]]++] = id;
+    }
+
+    for (IndexType id = numberOfNodes; id > 0; id--) {
+      childOffset_[id] = childOffset_[id - 1];
+    }
+    childOffset_[0] = 0;
+  }
+
+  template<class WeightType, class IndexType>
+  void MorphologicalTree<WeightType, IndexType>::computeCNPs()
+  {
+    // counting pass over cmap: the CNPs of node "id" are
+    // cnps_[cnpOffset_[id]..cnpOffset_[id+1]) in raster order.
+    const IndexType numberOfNodes = parent_.size();
+    cnpOffset_.assign(numberOfNodes + 1, 0);
+    for (IndexType p = 0; p < cmap_.size(); p++) {
+      cnpOffset_[cmap_[p] + 1]++;
+    }
+
+    for (IndexType id = 1; id <= numberOfNodes; id++) {
+      cnpOffset_[id] += cnpOffset_[id - 1];
+    }
+
+    cnps_.resize(cmap_.size());
+    for (IndexType p = 0; p < cmap_.size(); p++) {
+      cnps_[cnpOffset_[cmap_[p]]++] = p;
+    }
+
+    for (IndexType id = numberOfNodes; id > 0; id--) {
+      cnpOffset_[id] = cnpOffset_[id - 1];
+    }
+    cnpOffset_[0] = 0;
+  }
+
+  template<class WeightType, class IndexType>
+  void MorphologicalTree<WeightType, IndexType>::renumberDepthFirst()
+  {
+    const IndexType numberOfNodes = parent_.size();
+    std::vector<IndexType> newId(numberOfNodes);
+    IndexType nextId = 0;
+    forEachPreOrder([&newId, &nextId](NodePtr node) {
+      newId[node->id()] = nextId++;
+      return true;
+    });
+
+    std::vector<IndexType> parent(numberOfNodes);
+    std::vector<WeightType> level(numberOfNodes);
+    std::vector<IndexType> representative(numberOfNodes);
+    for (IndexType id = 0; id < numberOfNodes; id++) {
+      parent[newId[id]] = parent_[id] == UndefinedIndex ? UndefinedIndex : newId[parent_[id]];
+      level[newId[id]] = level_[id];
+      representative[newId[id]] = representative_[id];
     }
 
+    for (IndexType &nid : cmap_) {
+      nid = newId[nid];
+    }
+
+    parent_ = std::move(parent);
+    level_ = std::move(level);
+    representative_ = std::move(representative);
+    createNodes();
+    computeCNPs();
+    depthFirst_ = true;
+    computeDepthFirstCaches();
+  }
+
+  template<class WeightType, class IndexType>
+  void MorphologicalTree<WeightType, IndexType>::computeDepthFirstCaches()
+  {
+    const IndexType numberOfNodes = parent_.size();
+    depth_.assign(numberOfNodes, 0);
+    subtreeSize_.assign(numberOfNodes, 1);
+    leaves_.clear();
+
+    for (IndexType id = 1; id < numberOfNodes; id++) {
+      depth_[id] = depth_[parent_[id]] + 1;
+    }
+
+    for (IndexType id = numberOfNodes; id > 1; id--) {
+      subtreeSize_[parent_[id - 1]] += subtreeSize_[id - 1];
+    }
+
+    for (IndexType id = 0; id < numberOfNodes; id++) {
+      if (subtreeSize_[id] == 1)
+        leaves_.push_back(id);
+    }
+  }
+
+  template<class WeightType, class IndexType>
+  Span<const IndexType> MorphologicalTree<WeightType, IndexType>::subtreeCNPs(IndexType nodeId) const
+  {
+    return Span<const IndexType>{cnps_.data() + cnpOffset_[nodeId],
+      cnps_.data() + cnpOffset_[nodeId + subtreeSize_[nodeId]]};
+  }
+
+  template<class WeightType, class IndexType>
+  bool MorphologicalTree<WeightType, IndexType>::isDescendant(IndexType nodeId, IndexType ancestorId) const
+  {
+    if (depthFirst_)
+      return ancestorId <= nodeId && nodeId < ancestorId + subtreeSize_[ancestorId];
+
+    // ancestors have smaller ids.
+    while (nodeId > ancestorId)
+      nodeId = parent_[nodeId];
+    return nodeId == ancestorId;
+  }
+
+  template<class WeightType, class IndexType>
+  void MorphologicalTree<WeightType, IndexType>::bindNodes()
+  {
+    for (NodeType &node : nodes_) {
+      node.tree_ = this;
+    }
+  }
+
+  template<class WeightType, class IndexType>
+  const typename MorphologicalTree<WeightType, IndexType>::NodePtr
+  MorphologicalTree<WeightType, IndexType>::node(IndexType id) const
+  {
+    return const_cast<NodeType*>(&nodes_[id]);
+  }
+
+  template<class WeightType, class IndexType>
+  typename MorphologicalTree<WeightType, IndexType>::NodePtr
+  MorphologicalTree<WeightType, IndexType>::node(IndexType id)
+  {
+    return &nodes_[id];
+  }
+
+  template<class WeightType, class IndexType>
+  Span<const IndexType> MorphologicalTree<WeightType, IndexType>::children(IndexType nodeId) const
+  {
+    return Span<const IndexType>{children_.data() + childOffset_[nodeId],
+      children_.data() + childOffset_[nodeId+1]};
+  }
+
+  template<class WeightType, class IndexType>
+  Span<const IndexType> MorphologicalTree<WeightType, IndexType>::cnps(IndexType nodeId) const
+  {
+    return Span<const IndexType>{cnps_.data() + cnpOffset_[nodeId],
+      cnps_.data() + cnpOffset_[nodeId+1]};
+  }
+
+  template<class WeightType, class IndexType>
+  std::vector<IndexType>
+  MorphologicalTree<WeightType, IndexType>::reconstructNodes(std::function<bool(NodePtr)> keep) const
+  {
+    std::vector<IndexType> rec;
+
+    forEachPreOrder([&rec, &keep](NodePtr node) {
+      if (node->id() == 0 || !keep(node))
+        return true;
+
+      std::vector<IndexType> recn = node->reconstruct();
+      rec.insert(rec.end(), recn.begin(), recn.end());
+      return false;
+    });
+
     return rec;
   }
 
 
-  template<typename WeightType>  
-  std::vector<bool> MorphologicalTree<WeightType>::reconstructNodes(std::function<
+  template<class WeightType, class IndexType>
+  std::vector<bool> MorphologicalTree<WeightType, IndexType>::reconstructNodes(std::function<
     bool(NodePtr)> keep, const Box &domain) const
   {
     std::vector<bool> bin(domain.numberOfPoints(), false);
-    std::vector<uint32> pixels = reconstructNodes(keep);
+    std::vector<IndexType> pixels = reconstructNodes(keep);
 
-    for (const uint32 pidx : pixels) {
+    for (const IndexType pidx : pixels) {
       bin[pidx] = true;
     }
 
     return bin;
   }
-  
-  template<class WeightType>
-  void MorphologicalTree<WeightType>::tranverse(std::function<void(const NodePtr node)> visit) const 
+
+  template<class WeightType, class IndexType>
+  void MorphologicalTree<WeightType, IndexType>::tranverse(std::function<void(const NodePtr node)> visit) const
+  {
+    forEachPostOrder(visit);
+  }
+
+  template<class WeightType, class IndexType>
+  template<class Visitor>
+  void MorphologicalTree<WeightType, IndexType>::forEachPostOrder(Visitor &&visit) const
   {
-    for(uint32 i = 1; i <= nodes_.size(); i++)  {
-      visit(nodes_[nodes_.size() - i]);
+    // node ids are given in a top-down order (parent(id) < id), so 
+    // decreasing ids visit the children before their parents.
+    for (IndexType i = nodes_.size(); i > 0; i--) {
+      visit(node(i - 1));
     }
   }
 
-  template<class WeightType> 
-  MorphologicalTree<WeightType> buildMaxTree(const std::vector<WeightType> &f,
-    std::shared_ptr<Adjacency> adj)
+  template<class WeightType, class IndexType>
+  template<class Visitor>
+  void MorphologicalTree<WeightType, IndexType>::forEachPreOrder(Visitor &&visit) const
   {
-    CTBuilder<WeightType> builder;
-    std::vector<uint32> R = sortIncreasing(f);
-    return MorphologicalTree<WeightType>(MorphoTreeType::MaxTree, f, builder.build(f, adj, R));
+    if (nodes_.empty())
+      return;
+
+    std::vector<IndexType> stack;
+    stack.push_back(0);
+    while (!stack.empty()) {
+      IndexType nid = stack.back();
+      stack.pop_back();
+
+      if (!visit(node(nid)))
+        continue;
+
+      const IndexType *first = children_.data() + childOffset_[nid];
+      const IndexType *last = children_.data() + childOffset_[nid+1];
+      while (last != first) 
+        stack.push_back(*--last);
+    }
+  }
+
+  template<class WeightType, class IndexType>
+  template<class Visitor>
+  void MorphologicalTree<WeightType, IndexType>::forEachBFS(Visitor &&visit) const
+  {
+    if (nodes_.empty())
+      return;
+
+    // the visiting order is its own queue.
+    std::vector<IndexType> queue;
+    queue.reserve(nodes_.size());
+    queue.push_back(0);
+    for (IndexType head = 0; head < queue.size(); head++) {
+      IndexType nid = queue[head];
+      visit(node(nid));
+      for (IndexType c : children(nid))
+        queue.push_back(c);
+    }
   }
 
   template<class WeightType>
-  MorphologicalTree<WeightType> buildMinTree(const std::vector<WeightType> &f,
-    std::shared_ptr<Adjacency> adj)
+  CTBuilderResult buildComponentTree(const std::vector<WeightType> &f,
+    std::shared_ptr<Adjacency> adj, std::vector<uint32> R, uint32 numberOfThreads,
+    ParallelEngine engine)
   {
-    CTBuilder<WeightType> builder;
-    std::vector<uint32> R = sortDecreasing(f);
-    return MorphologicalTree<WeightType>(MorphoTreeType::MinTree, f, builder.build(f, adj, R));
+    if (numberOfThreads <= 1)
+      return CTBuilder<WeightType>().build(f, adj, std::move(R));
+    if (engine == ParallelEngine::ConcurrentUnionFind)
+      return ConcurrentCTBuilder<WeightType>(numberOfThreads).build(f, adj, std::move(R));
+    return ParallelCTBuilder<WeightType>(numberOfThreads).build(f, adj, std::move(R));
   }
 
-  template<typename WeightType>
-  std::vector<WeightType> MorphologicalTree<WeightType>::reconstructImage() const
+  template<class WeightType>
+  CTBuilderResult buildComponentTree(IndexTag<uint32>, const std::vector<WeightType> &f,
+    std::shared_ptr<Adjacency> adj, bool maxTree, uint32 numberOfThreads, ParallelEngine engine)
   {
-    std::vector<WeightType> f(cmap_.size());
-    for (NodePtr node : nodes_) {
-      for (uint idx : node->cnps()) {
-        f[idx] = node->level();
-      }
+    // low bit-depth images are flooded with a hierarchical queue.
+    if (numberOfThreads <= 1 && FloodCTBuilder<WeightType>::isSupported()) {
+      return maxTree ? FloodCTBuilder<WeightType>().buildMaxTree(f, adj)
+                     : FloodCTBuilder<WeightType>().buildMinTree(f, adj);
     }
-    return f;
+    return buildComponentTree(f, adj,
+      maxTree ? sortIncreasing(f, numberOfThreads) : sortDecreasing(f, numberOfThreads),
+      numberOfThreads, engine);
   }
-  template<typename WeightType>
-  std::vector<WeightType> MorphologicalTree<WeightType>::reconstructImage(
-    std::function<bool(const NodePtr)> keep) const
+
+  template<class WeightType, class IndexType>
+  BasicCTBuilderResult<IndexType> buildComponentTree(IndexTag<IndexType>,
+    const std::vector<WeightType> &f, std::shared_ptr<Adjacency> adj, bool maxTree,
+    uint32 numberOfThreads, ParallelEngine)
   {
-    using namespace std;
-    vector<vector<uint32>> up(numberOfNodes(), vector<uint32>());
-    vector<WeightType> f(cmap_.size(), 0);
-
-    tranverse([&up, &keep, &f](const NodePtr node){
-      if (keep(node)) {
-        for (uint32 pidx : node->cnps()) 
-          f[pidx] = node->level();
-        
-        for (uint32 pidx : up[node->id()]) 
-          f[pidx] = node->level();          
-      }
-      else {        
-        const vector<uint32> &cnps = node->cnps();
-        const vector<uint32> &upCnps = up[node->id()];
-        vector<uint32> &upParent = up[node->parent()->id()];
+    if (numberOfThreads > 1)
+      throw std::runtime_error("only trees with uint32 indices are built with several threads");
 
-        upParent.insert(upParent.end(), cnps.begin(), cnps.end());
-        upParent.insert(upParent.end(), upCnps.begin(), upCnps.end());
-      }
+    // R is sorted straight into IndexType, so it takes no uint32 storage.
+    std::vector<IndexType> R;
+    RadixSorter<WeightType, IndexType>().sort(f, maxTree, R, 1);
+    return CTBuilder<WeightType, IndexType>().build(f, adj, std::move(R));
+  }
+
+  template<class WeightType, class IndexType>
+  MorphologicalTree<WeightType, IndexType> buildMaxTree(const std::vector<WeightType> &f,
+    std::shared_ptr<Adjacency> adj, NodeOrdering ordering, uint32 numberOfThreads,
+    ParallelEngine engine)
+  {
+    MorphologicalTree<WeightType, IndexType> tree(MorphoTreeType::MaxTree, f,
+      buildComponentTree(IndexTag<IndexType>{}, f, adj, true, numberOfThreads, engine));
+    if (ordering == NodeOrdering::DepthFirst)
+      tree.renumberDepthFirst();
+    return tree;
+  }
+
+  template<class WeightType, class IndexType>
+  MorphologicalTree<WeightType, IndexType> buildMinTree(const std::vector<WeightType> &f,
+    std::shared_ptr<Adjacency> adj, NodeOrdering ordering, uint32 numberOfThreads,
+    ParallelEngine engine)
+  {
+    MorphologicalTree<WeightType, IndexType> tree(MorphoTreeType::MinTree, f,
+      buildComponentTree(IndexTag<IndexType>{}, f, adj, false, numberOfThreads, engine));
+    if (ordering == NodeOrdering::DepthFirst)
+      tree.renumberDepthFirst();
+    return tree;
+  }
+
+  template<class WeightType, class Visitor>
+  auto withNarrowestMaxTree(const std::vector<WeightType> &f, std::shared_ptr<Adjacency> adj,
+    Visitor &&visit, NodeOrdering ordering)
+  {
+    return withNarrowestIndex(f.size(), [&](auto tag) {
+      using IndexType = typename decltype(tag)::Type;
+      return visit(buildMaxTree<WeightType, IndexType>(f, adj, ordering));
     });
+  }
 
-    return f;
+  template<class WeightType, class Visitor>
+  auto withNarrowestMinTree(const std::vector<WeightType> &f, std::shared_ptr<Adjacency> adj,
+    Visitor &&visit, NodeOrdering ordering)
+  {
+    return withNarrowestIndex(f.size(), [&](auto tag) {
+      using IndexType = typename decltype(tag)::Type;
+      return visit(buildMinTree<WeightType, IndexType>(f, adj, ordering));
+    });
   }
 
   template<class WeightType>
-  void MorphologicalTree<WeightType>::idirectFilter(std::function<bool(const NodePtr)> keep)
+  MaxAndMinTrees<WeightType> buildMaxAndMinTrees(const std::vector<WeightType> &f,
+    std::shared_ptr<Adjacency> adj, NodeOrdering ordering, uint32 numberOfThreads)
   {
-    performDirectFilter(*this, keep);
+    MaxAndMinTrees<WeightType> trees{MorphologicalTree<WeightType>(MorphoTreeType::MaxTree),
+      MorphologicalTree<WeightType>(MorphoTreeType::MinTree)};
+    const int numberOfPasses = numberOfThreads <= 1 ? 1 : 2;
+
+    if (FloodCTBuilder<WeightType>::isSupported()) {
+      #pragma omp parallel sections num_threads(numberOfPasses)
+      {
+        #pragma omp section
+        trees.maxTree = MorphologicalTree<WeightType>(MorphoTreeType::MaxTree, f,
+          FloodCTBuilder<WeightType>().buildMaxTree(f, adj));
+
+        #pragma omp section
+        trees.minTree = MorphologicalTree<WeightType>(MorphoTreeType::MinTree, f,
+          FloodCTBuilder<WeightType>().buildMinTree(f, adj));
+      }
+    }
+    else if (numberOfPasses == 1) {
+      CTBuilder<WeightType> builder;
+      CTBuilderResult res = builder.build(f, adj, sortIncreasing(f));
+      trees.maxTree = MorphologicalTree<WeightType>(MorphoTreeType::MaxTree, f, res);
+      reverseLevelOrder(f, res.R);
+      res = builder.build(f, adj, std::move(res.R));
+      trees.minTree = MorphologicalTree<WeightType>(MorphoTreeType::MinTree, f, res);
+    }
+    else {
+      std::vector<uint32> R = sortIncreasing(f, numberOfThreads);
+      std::vector<uint32> dualR = R;
+      reverseLevelOrder(f, dualR);
+
+      #pragma omp parallel sections num_threads(numberOfPasses)
+      {
+        #pragma omp section
+        trees.maxTree = MorphologicalTree<WeightType>(MorphoTreeType::MaxTree, f,
+          CTBuilder<WeightType>().build(f, adj, std::move(R)));
+
+        #pragma omp section
+        trees.minTree = MorphologicalTree<WeightType>(MorphoTreeType::MinTree, f,
+          CTBuilder<WeightType>().build(f, adj, std::move(dualR)));
+      }
+    }
+
+    if (ordering == NodeOrdering::DepthFirst) {
+      trees.maxTree.renumberDepthFirst();
+      trees.minTree.renumberDepthFirst();
+    }
+    return trees;
   }
 
-  template<class WeightType>
-  MorphologicalTree<WeightType> MorphologicalTree<WeightType>::directFilter(
+  template<class WeightType, class IndexType>
+  std::vector<WeightType> MorphologicalTree<WeightType, IndexType>::reconstructImage() const
+  {
+    std::vector<WeightType> f(cmap_.size());
+    const int numberOfPixels = static_cast<int>(cmap_.size());
+
+    #pragma omp parallel for
+    for (int idx = 0; idx < numberOfPixels; idx++) {
+      f[idx] = level_[cmap_[idx]];
+    }
+    return f;
+  }
+
+  template<class WeightType, class IndexType>
+  std::vector<WeightType> MorphologicalTree<WeightType, IndexType>::reconstructImage(
     std::function<bool(const NodePtr)> keep) const
   {
-    MorphologicalTree<WeightType> ctree = copy();
-    performDirectFilter(ctree, keep);
-    return ctree;
+    return reconstructImage(keepMask(keep));
   }
 
-  template<typename WeightType>
-  void MorphologicalTree<WeightType>::performDirectFilter(MorphologicalTree<WeightType> &tree, 
-    std::function<bool(const NodePtr)> keep) const 
+  template<class WeightType, class IndexType>
+  std::vector<WeightType> MorphologicalTree<WeightType, IndexType>::reconstructImage(
+    const std::vector<bool> &keep) const
   {
-    // remove node from data structure.
-    uint32 numRemovedNodes = 0;
-      
-    std::queue<NodePtr> queue;
-    queue.push(tree.root());
+    std::vector<WeightType> f;
+    reconstructImage(keep, f);
+    return f;
+  }
 
-    while (!queue.empty())
-    {
-      NodePtr node = queue.front();
-      queue.pop();
-      
-      for (NodePtr c : node->children()) {
-        queue.push(c);
-      }
+  template<class WeightType, class IndexType>
+  void MorphologicalTree<WeightType, IndexType>::reconstructImage(const std::vector<bool> &keep, 
+    std::vector<WeightType> &f) const
+  {
+    // output level of every node: its own level if it is kept and the level
+    // of its nearest kept ancestor otherwise (parent(id) < id).
+    std::vector<WeightType> outLevel(level_.size());
+    for (IndexType id = 0; id < level_.size(); id++) {
+      if (parent_[id] == UndefinedIndex || keep[id])
+        outLevel[id] = level_[id];
+      else
+        outLevel[id] = outLevel[parent_[id]];
+    }
 
-      if (!keep(node) && node->parent() != nullptr) {
-        numRemovedNodes++;  
-        NodePtr parentNode = node->parent();
-        parentNode->includeCNPS(node->cnps());
-        parentNode->removeChild(node);
-        for (NodePtr c : node->children()) {
-          parentNode->appendChild(c);
-          c->parent(parentNode);
-        }
-      }
+    f.resize(cmap_.size());
+    const int numberOfPixels = static_cast<int>(cmap_.size());
+
+    #pragma omp parallel for
+    for (int idx = 0; idx < numberOfPixels; idx++) {
+      f[idx] = outLevel[cmap_[idx]];
     }
+  }
 
-    // fix cmap and nodes arrays
-    uint32 prevNumOfNodes = tree.numberOfNodes();
-    tree.nodes_.clear();
-    tree.nodes_.resize(prevNumOfNodes - numRemovedNodes);
-    uint32 newId = 0;
-    tree.traverseByLevel([&tree, &newId](NodePtr n) {
-      n->id(newId);
-      tree.nodes_[newId] = n;
-      for (uint32 idx : n->cnps()) {
-        tree.cmap_[idx] = newId;
-      }
-      newId++;
-    }); 
+  template<class WeightType, class IndexType>
+  void MorphologicalTree<WeightType, IndexType>::idirectFilter(std::function<bool(const NodePtr)> keep)
+  {
+    idirectFilter(keepMask(keep));
   }
 
-  template<typename WeightType>
-  void MorphologicalTree<WeightType>::traverseByLevel(std::function<void(const NodePtr)> visit) const
+  template<class WeightType, class IndexType>
+  MorphologicalTree<WeightType, IndexType> MorphologicalTree<WeightType, IndexType>::directFilter(
+    std::function<bool(const NodePtr)> keep) const
   {
-    std::queue<NodePtr> queue;
-    queue.push(root());
+    return directFilter(keepMask(keep));
+  }
 
-    while (!queue.empty())
-    {
-      NodePtr node = queue.front();
-      queue.pop();
-      visit(node);
-      for (NodePtr c : node->children()) {
-        queue.push(c);
-      }
-    }
+  template<class WeightType, class IndexType>
+  void MorphologicalTree<WeightType, IndexType>::idirectFilter(const std::vector<bool> &keep)
+  {
+    std::vector<IndexType> newId;
+    performDirectFilter(*this, keep, newId);
   }
 
-  template<typename WeightType>
-  void MorphologicalTree<WeightType>::traverseByLevel(std::function<void(NodePtr)> visit)
+  template<class WeightType, class IndexType>
+  void MorphologicalTree<WeightType, IndexType>::idirectFilter(const std::vector<bool> &keep,
+    std::vector<IndexType> &newId)
   {
-    std::queue<NodePtr> queue;
-    queue.push(root());
+    performDirectFilter(*this, keep, newId);
+  }
 
-    while (!queue.empty())
-    {
-      NodePtr node = queue.front();
-      queue.pop();
-      visit(node);
-      for (NodePtr c : node->children()) {
-        queue.push(c);
+  template<class WeightType, class IndexType>
+  MorphologicalTree<WeightType, IndexType> MorphologicalTree<WeightType, IndexType>::directFilter(
+    const std::vector<bool> &keep) const
+  {
+    std::vector<IndexType> newId;
+    return directFilter(keep, newId);
+  }
+
+  template<class WeightType, class IndexType>
+  MorphologicalTree<WeightType, IndexType> MorphologicalTree<WeightType, IndexType>::directFilter(
+    const std::vector<bool> &keep, std::vector<IndexType> &newId) const
+  {
+    MorphologicalTree<WeightType, IndexType> ftree{type_};
+    performDirectFilter(ftree, keep, newId);
+    return ftree;
+  }
+
+  template<class WeightType, class IndexType>
+  std::vector<bool> MorphologicalTree<WeightType, IndexType>::keepMask(
+    std::function<bool(const NodePtr)> keep) const
+  {
+    std::vector<bool> mask(nodes_.size(), true);
+    for (IndexType id = 1; id < nodes_.size(); id++) {
+      mask[id] = keep(node(id));
+    }
+    return mask;
+  }
+
+  template<class WeightType, class IndexType>
+  void MorphologicalTree<WeightType, IndexType>::performDirectFilter(MorphologicalTree<WeightType, IndexType> &tree,
+    const std::vector<bool> &keep, std::vector<IndexType> &newId) const
+  {
+    const IndexType numberOfNodes = parent_.size();
+
+    // Since parent(id) < id, a single pass in increasing id order maps each
+    // node to itself if it is kept ("target") or to its nearest kept
+    // ancestor otherwise, and numbers the kept nodes by rank, which 
+    // preserves the top-down order of the ids. The root is never removed.
+    std::vector<IndexType> target(numberOfNodes);
+    newId.assign(numberOfNodes, UndefinedIndex);
+    IndexType numberOfKeptNodes = 0;
+    for (IndexType id = 0; id < numberOfNodes; id++) {
+      if (parent_[id] == UndefinedIndex || keep[id]) {
+        target[id] = id;
+        newId[id] = numberOfKeptNodes++;
+      }
+      else {
+        target[id] = target[parent_[id]];
       }
     }
+
+    std::vector<IndexType> parent(numberOfKeptNodes);
+    std::vector<WeightType> level(numberOfKeptNodes);
+    std::vector<IndexType> representative(numberOfKeptNodes);
+    for (IndexType id = 0; id < numberOfNodes; id++) {
+      if (target[id] != id) 
+        continue;
+
+      IndexType nid = newId[id];
+      parent[nid] = parent_[id] == UndefinedIndex ? UndefinedIndex : newId[target[parent_[id]]];
+      level[nid] = level_[id];
+      representative[nid] = representative_[id];
+    }
+
+    std::vector<IndexType> cmap(cmap_.size());
+    for (IndexType idx = 0; idx < cmap_.size(); idx++) {
+      cmap[idx] = newId[target[cmap_[idx]]];
+    }
+
+    tree.parent_ = std::move(parent);
+    tree.level_ = std::move(level);
+    tree.representative_ = std::move(representative);
+    tree.cmap_ = std::move(cmap);
+    tree.type_ = type_;
+    tree.createNodes();
+    tree.computeCNPs();
+
+    // ranking the kept nodes preserves the depth-first numbering.
+    tree.depthFirst_ = depthFirst_;
+    if (tree.depthFirst_)
+      tree.computeDepthFirstCaches();
   }
 
-  template<class WeightType>
-  typename MorphologicalTree<WeightType>::NodePtr 
-  MorphologicalTree<WeightType>::smallComponent(uint32 idx, const std::vector<bool> &mask)
+  template<class WeightType, class IndexType>
+  void MorphologicalTree<WeightType, IndexType>::traverseByLevel(std::function<void(const NodePtr)> visit) const
   {
-    NodePtr node = nodes_[cmap_[idx]];
-    while (!mask[node->id()] && node->id() != 0) 
-      node = node->parent();
-    
-    return node;
+    forEachBFS(visit);
   }
 
-  template<class WeightType>
-  const typename MorphologicalTree<WeightType>::NodePtr 
-  MorphologicalTree<WeightType>::smallComponent(uint32 idx, const std::vector<bool> &mask) const
+  template<class WeightType, class IndexType>
+  void MorphologicalTree<WeightType, IndexType>::traverseByLevel(std::function<void(NodePtr)> visit)
   {
-    NodePtr node = nodes_[cmap_[idx]];
-    while (!mask[node->id()] && node->id() != 0) 
-      node = node->parent();
-    
-    return node;
+    forEachBFS(visit);
   }
 
-  template<class WeightType>
-  MorphologicalTree<WeightType> MorphologicalTree<WeightType>::copy() const
+  template<class WeightType, class IndexType>
+  std::vector<IndexType> MorphologicalTree<WeightType, IndexType>::smallComponents(
+    const std::vector<bool> &mask) const
   {
-    MorphologicalTree ctree{type_};
-    ctree.nodes_.reserve(numberOfNodes());
-    ctree.cmap_ = cmap_;
+    // nearest masked ancestor (or the node itself) of every node, which is
+    // resolved top-down since parent(id) < id.
+    std::vector<IndexType> target(parent_.size());
+    for (IndexType id = 0; id < parent_.size(); id++) {
+      target[id] = (id == 0 || mask[id]) ? id : target[parent_[id]];
+    }
+
+    std::vector<IndexType> sc(cmap_.size());
+    const int numberOfPixels = static_cast<int>(cmap_.size());
 
-    for (NodePtr node : nodes_) {
-      ctree.nodes_.push_back(node->copy());
+    #pragma omp parallel for
+    for (int idx = 0; idx < numberOfPixels; idx++) {
+      sc[idx] = target[cmap_[idx]];
     }
+    return sc;
+  }
 
-    traverseByLevel([this, &ctree](NodePtr node) {
-      NodePtr cnode = ctree.nodes_[node->id()];
-      
-      if (node->parent() != nullptr) {
-        NodePtr cparent = ctree.nodes_[node->parent()->id()];
-        cnode->parent(cparent);
-        cparent->appendChild(cnode); 
-      }
-    });
-    ctree.root_ = ctree.nodes_[0];
-    return ctree;
+  template<class WeightType, class IndexType>
+  typename MorphologicalTree<WeightType, IndexType>::NodePtr
+  MorphologicalTree<WeightType, IndexType>::smallComponent(IndexType idx, const std::vector<bool> &mask)
+  {
+    IndexType nid = cmap_[idx];
+    while (!mask[nid] && nid != 0)
+      nid = parent_[nid];
+
+    return node(nid);
+  }
+
+  template<class WeightType, class IndexType>
+  const typename MorphologicalTree<WeightType, IndexType>::NodePtr
+  MorphologicalTree<WeightType, IndexType>::smallComponent(IndexType idx, const std::vector<bool> &mask) const
+  {
+    IndexType nid = cmap_[idx];
+    while (!mask[nid] && nid != 0)
+      nid = parent_[nid];
+
+    return node(nid);
+  }
+
+  template<class WeightType, class IndexType>
+  MorphologicalTree<WeightType, IndexType> MorphologicalTree<WeightType, IndexType>::copy() const
+  {
+    return MorphologicalTree<WeightType, IndexType>{*this};
   }
-} 
\ No newline at end of file
+}
\ No newline at end of file
@@ -0,0 +1,276 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+#include "morphotree/adjacency/adjacency.hpp"
+#include "morphotree/adjacency/adjacencyDispatch.hpp"
+#include "morphotree/tree/ct_builder.hpp"
+#include "morphotree/tree/levelRootMerge.hpp"
+
+#include <omp.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <limits>
+#include <memory>
+
+namespace morphotree
+{
+  // ParallelCTBuilder computes the same CTBuilderResult as CTBuilder using
+  // several threads, following the concurrent max-tree of Wilkinson et al.:
+  // the elements are split into contiguous index ranges (horizontal stripes
+  // of a raster image), a partial component tree is built for each stripe
+  // concurrently, and the trees of neighbouring stripes are merged pairwise
+  // along the edges crossing their borders. The level root of each node is
+  // the last element of the node in R, as in CTBuilder, so both builders
+  // produce the same parent array. R must be sorted by level, as produced
+  // by sortIncreasing and sortDecreasing.
+  template<class WeightType>
+  class ParallelCTBuilder
+  {
+  public:
+    ParallelCTBuilder(uint32 numberOfThreads);
+
+    inline uint32 numberOfThreads() const { return numberOfThreads_; }
+
+    CTBuilderResult build(const std::vector<WeightType> &f,
+                          std::shared_ptr<Adjacency> adj,
+                          std::vector<uint32> R);
+
+    template<class AdjacencyType, class = RequireAdjacency<AdjacencyType>>
+    CTBuilderResult build(const std::vector<WeightType> &f,
+                          const AdjacencyType &adj,
+                          std::vector<uint32> R);
+
+  private:
+    static const uint32 UNDEF;
+    using Edge = std::pair<uint32, uint32>;
+
+    void splitStripes(uint32 numberOfElements);
+    inline uint32 stripeOf(uint32 p) const;
+    std::vector<uint32> stripeOrders(const std::vector<uint32> &R) const;
+    template<class AdjacencyType>
+    void buildStripe(uint32 s, const std::vector<WeightType> &f,
+      const AdjacencyType &adj, const std::vector<uint32> &SR,
+      std::vector<uint32> &parent);
+    void mergeStripes(const std::vector<WeightType> &f, std::vector<uint32> &parent) const;
+    std::vector<uint32> canonicalParents(const std::vector<WeightType> &f,
+      const std::vector<uint32> &R, std::vector<uint32> &parent);
+
+    uint32 findRoot(uint32 x);
+
+  private:
+    uint32 numberOfThreads_;
+    uint32 numberOfStripes_;
+    bool decreasing_;
+    std::vector<uint32> begin_;
+    std::vector<uint32> zpar_;
+    std::vector<std::vector<Edge>> borderEdges_;
+  };
+
+  template<class WeightType>
+  const uint32 ParallelCTBuilder<WeightType>::UNDEF = std::numeric_limits<uint32>::max();
+
+  // =============== [IMPLEMENTATION] ==================================================
+  template<class WeightType>
+  ParallelCTBuilder<WeightType>::ParallelCTBuilder(uint32 numberOfThreads)
+    :numberOfThreads_{std::max<uint32>(numberOfThreads, 1)}, numberOfStripes_{1},
+     decreasing_{true}
+  {}
+
+  template<class WeightType>
+  CTBuilderResult ParallelCTBuilder<WeightType>::build(const std::vector<WeightType> &f,
+    std::shared_ptr<Adjacency> adj, std::vector<uint32> R)
+  {
+    return withStaticAdjacency(*adj, [&](const auto &a) { return build(f, a, std::move(R)); });
+  }
+
+  template<class WeightType>
+  template<class AdjacencyType, class>
+  CTBuilderResult ParallelCTBuilder<WeightType>::build(const std::vector<WeightType> &f,
+    const AdjacencyType &adj, std::vector<uint32> R)
+  {
+    const uint32 numberOfElements = f.size();
+    decreasing_ = R.empty() || f[R.front()] >= f[R.back()];
+    splitStripes(numberOfElements);
+
+    std::vector<uint32> SR = stripeOrders(R);
+    std::vector<uint32> parent(numberOfElements);
+    zpar_.assign(numberOfElements, UNDEF);
+    borderEdges_.assign(numberOfStripes_, std::vector<Edge>());
+
+    const int numberOfStripes = static_cast<int>(numberOfStripes_);
+    #pragma omp parallel for num_threads(numberOfThreads_) schedule(dynamic, 1)
+    for (int s = 0; s < numberOfStripes; s++) {
+      buildStripe(s, f, adj, SR, parent);
+    }
+
+    mergeStripes(f, parent);
+    std::vector<uint32> canonical = canonicalParents(f, R, parent);
+    return CTBuilderResult{std::move(canonical), std::move(R)};
+  }
+
+  template<class WeightType>
+  void ParallelCTBuilder<WeightType>::splitStripes(uint32 numberOfElements)
+  {
+    numberOfStripes_ = std::max<uint32>(1, std::min(numberOfThreads_, numberOfElements));
+    begin_.resize(numberOfStripes_ + 1);
+    for (uint32 s = 0; s <= numberOfStripes_; s++) {
+      begin_[s] = static_cast<uint32>(
+        (static_cast<uint64>(numberOfElements) * s) / numberOfStripes_);
+    }
+  }
+
+  template<class WeightType>
+  uint32 ParallelCTBuilder<WeightType>::stripeOf(uint32 p) const
+  {
+    return std::upper_bound(begin_.begin(), begin_.end(), p) - begin_.begin() - 1;
+  }
+
+  template<class WeightType>
+  std::vector<uint32> ParallelCTBuilder<WeightType>::stripeOrders(
+    const std::vector<uint32> &R) const
+  {
+    // stable partition of R by stripe: the order of stripe s is stored in
+    // SR[begin_[s]], ..., SR[begin_[s+1]-1]. R is split in the same ranges
+    // as the elements, and each range of R is scattered by one thread.
+    const uint32 S = numberOfStripes_;
+    const int numberOfStripes = static_cast<int>(S);
+    std::vector<uint32> SR(R.size());
+    std::vector<uint32> offset(S * S, 0);
+
+    #pragma omp parallel for num_threads(numberOfThreads_)
+    for (int c = 0; c < numberOfStripes; c++) {
+      for (uint32 i = begin_[c]; i < begin_[c+1]; i++)
+        offset[c * S + stripeOf(R[i])]++;
+    }
+
+    for (uint32 s = 0; s < S; s++) {
+      uint32 next = begin_[s];
+      for (uint32 c = 0; c < S; c++) {
+        uint32 count = offset[c * S + s];
+        offset[c * S + s] = next;
+        next += count;
+      }
+    }
+
+    #pragma omp parallel for num_threads(numberOfThreads_)
+    for (int c = 0; c < numberOfStripes; c++) {
+      for (uint32 i = begin_[c]; i < begin_[c+1]; i++)
+        SR[offset[c * S + stripeOf(R[i])]++] = R[i];
+    }
+    return SR;
+  }
+
+  template<class WeightType>
+  template<class AdjacencyType>
+  void ParallelCTBuilder<WeightType>::buildStripe(uint32 s, const std::vector<WeightType> &f,
+    const AdjacencyType &adj, const std::vector<uint32> &SR, std::vector<uint32> &parent)
+  {
+    // same union-find as CTBuilder::build restricted to the elements of the
+    // stripe. The edges leaving the stripe towards the next ones are kept to
+    // be merged later.
+    const uint32 first = begin_[s], last = begin_[s+1];
+    std::vector<Edge> &border = borderEdges_[s];
+
+    for (uint32 i = first; i < last; i++) {
+      uint32 p = SR[i];
+      parent[p] = p;
+      zpar_[p] = p;
+      adj.forEachNeighbour(p, [&](uint32 n) {
+        if (n < first || n >= last) {
+          if (n >= last)
+            border.push_back(Edge{p, n});
+        }
+        else if (zpar_[n] != UNDEF) {
+          uint32 r = findRoot(n);
+          if (r != p) {
+            parent[r] = p;
+            zpar_[r] = p;
+          }
+        }
+      });
+    }
+
+    for (uint32 i = last; i > first; i--) {
+      uint32 p = SR[i-1];
+      uint32 q = parent[p];
+      if (f[parent[q]] == f[q])
+        parent[p] = parent[q];
+    }
+  }
+
+  template<class WeightType>
+  void ParallelCTBuilder<WeightType>::mergeStripes(const std::vector<WeightType> &f,
+    std::vector<uint32> &parent) const
+  {
+    // stripes are merged as a binary reduction: at round r, the groups of
+    // 2^r stripes [2k 2^r, (2k+1) 2^r) and [(2k+1) 2^r, (2k+2) 2^r) are
+    // merged, concurrently for all k, through the border edges joining them.
+    // An edge joining stripes a and b belongs to the round given by the
+    // highest bit of a xor b. The groups of a round share no element, so
+    // they are merged without locks.
+    LevelRootMerge<WeightType> merge{parent, f, decreasing_};
+    for (uint32 r = 0; (uint32(1) << r) < numberOfStripes_; r++) {
+      const uint32 groupSize = uint32(1) << (r + 1);
+      const int numberOfGroups = static_cast<int>((numberOfStripes_ + groupSize - 1) / groupSize);
+
+      #pragma omp parallel for num_threads(numberOfThreads_)
+      for (int g = 0; g < numberOfGroups; g++) {
+        uint32 lastStripe = std::min(numberOfStripes_, (g + 1) * groupSize);
+        for (uint32 s = g * groupSize; s < lastStripe; s++) {
+          for (const Edge &e : borderEdges_[s]) {
+            uint32 diff = s ^ stripeOf(e.second);
+            uint32 round = 0;
+            while (diff >>= 1)
+              round++;
+            if (round == r)
+              merge.connect(e.first, e.second);
+          }
+        }
+      }
+    }
+  }
+
+  template<class WeightType>
+  std::vector<uint32> ParallelCTBuilder<WeightType>::canonicalParents(
+    const std::vector<WeightType> &f, const std::vector<uint32> &R,
+    std::vector<uint32> &parent)
+  {
+    // the merges leave chains of same level elements. Every element is
+    // pointed to the last element of its node in R (the level root chosen
+    // by CTBuilder), and level roots to the level root of the parent node.
+    const int numberOfElements = static_cast<int>(f.size());
+    std::vector<uint32> &root = zpar_;
+    std::vector<uint32> rep(f.size());
+    std::vector<uint32> canonical(f.size());
+    const LevelRootMerge<WeightType> merge{parent, f, decreasing_};
+
+    #pragma omp parallel for num_threads(numberOfThreads_)
+    for (int p = 0; p < numberOfElements; p++) {
+      root[p] = merge.findLevelRoot(p);
+    }
+
+    for (uint32 p : R)
+      rep[root[p]] = p;
+
+    #pragma omp parallel for num_threads(numberOfThreads_)
+    for (int p = 0; p < numberOfElements; p++) {
+      uint32 r = root[p];
+      if (rep[r] != static_cast<uint32>(p))
+        canonical[p] = rep[r];
+      else
+        canonical[p] = parent[r] == r ? p : rep[root[parent[r]]];
+    }
+    return canonical;
+  }
+
+  template<class WeightType>
+  uint32 ParallelCTBuilder<WeightType>::findRoot(uint32 x)
+  {
+    while (zpar_[x] != x) {
+      zpar_[x] = zpar_[zpar_[x]];
+      x = zpar_[x];
+    }
+    return x;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,322 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+#include "morphotree/adjacency/adjacency.hpp"
+#include "morphotree/tree/mtree.hpp"
+#include "morphotree/tree/levelRootMerge.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace morphotree
+{
+  // bounding box of a streamed node: the columns [left, right] and the
+  // rows [top, bottom]. Rows are counted from the first row of the image on
+  // 64 bits, since the stream may not end.
+  struct StreamBox
+  {
+    uint32 left;
+    uint32 right;
+    uint64 top;
+    uint64 bottom;
+  };
+
+  // node of a streamed max-tree or min-tree, with its area, bounding box
+  // and volume (the volume of VolumeComputer).
+  template<class WeightType>
+  struct StreamComponent
+  {
+    WeightType level;
+    uint64 area;
+    StreamBox boundingBox;
+    double volume;
+  };
+
+  // StreamingCTBuilder builds the max-tree or min-tree of an image which
+  // arrives row by row, of a fixed width and an unknown (possibly endless)
+  // height. A node is final once it does not touch the last pushed row (the
+  // frontier), since later rows only connect to the frontier; final nodes
+  // are given to "emit" right after the row which makes them final,
+  // children before their parents. finish() ends the image and emits the
+  // remaining nodes, the root last.
+  //
+  // Only the active nodes, those which touch the frontier and their
+  // ancestors, are kept. Each row is first turned into its own 1D tree
+  // (with a stack), which is merged with the active nodes along the edges
+  // to the frontier by LevelRootMerge (Wilkinson et al.).
+  // Every active node holds the area, sum of values and bounding box of
+  // its pixels and of its emitted descendants, so the attributes of a node
+  // are complete when it is emitted; they are folded into its parent then.
+  template<class WeightType>
+  class StreamingCTBuilder
+  {
+  public:
+    using ComponentType = StreamComponent<WeightType>;
+    using EmitFunction = std::function<void(const ComponentType&)>;
+
+    StreamingCTBuilder(MorphoTreeType type, uint32 width, EmitFunction emit,
+      GridConnectivity connectivity = GridConnectivity::Adjacency4C);
+
+    void pushRow(const WeightType *row);
+    void pushRow(const std::vector<WeightType> &row);
+
+    // emits the nodes left and starts a new image.
+    void finish();
+
+    inline uint32 width() const { return width_; }
+    inline uint64 numberOfRows() const { return numberOfRows_; }
+    inline uint32 numberOfActiveNodes() const { return parent_.size(); }
+
+  private:
+    static const uint32 UNDEF;
+
+    void addRowNodes(const WeightType *row);
+    void connectFrontier();
+    void emitFinalNodes(bool finishing);
+
+    uint32 newNode(WeightType level);
+    void fold(uint32 from, uint32 to);
+    inline bool isDeeper(WeightType a, WeightType b) const { return maxTree_ ? a > b : a < b; }
+
+  private:
+    bool maxTree_;
+    uint32 width_;
+    EmitFunction emit_;
+    GridConnectivity connectivity_;
+    uint64 numberOfRows_;
+    bool hasFrontier_;
+
+    // active nodes, then the nodes of the last row.
+    std::vector<uint32> parent_;
+    std::vector<WeightType> level_;
+    std::vector<uint64> area_;
+    std::vector<double> valueSum_;
+    std::vector<StreamBox> boundingBox_;
+
+    // node of every pixel of the frontier and of the last row.
+    std::vector<uint32> frontier_;
+    std::vector<uint32> row_;
+
+    std::vector<uint32> stack_;
+    std::vector<uint32> root_;
+    std::vector<uint32> newIndex_;
+    std::vector<uint32> final_;
+  };
+
+  // =============== [IMPLEMENTATION] ==================================================
+  template<class WeightType>
+  const uint32 StreamingCTBuilder<WeightType>::UNDEF = std::numeric_limits<uint32>::max();
+
+  template<class WeightType>
+  StreamingCTBuilder<WeightType>::StreamingCTBuilder(MorphoTreeType type, uint32 width,
+    EmitFunction emit, GridConnectivity connectivity)
+    :maxTree_{type == MorphoTreeType::MaxTree}, width_{width}, emit_{std::move(emit)},
+     connectivity_{connectivity}, numberOfRows_{0}, hasFrontier_{false}
+  {
+    if (type != MorphoTreeType::MaxTree && type != MorphoTreeType::MinTree)
+      throw std::runtime_error("StreamingCTBuilder builds max-trees and min-trees only");
+    if (width == 0)
+      throw std::runtime_error("the rows must not be empty");
+    row_.resize(width);
+  }
+
+  template<class WeightType>
+  void StreamingCTBuilder<WeightType>::pushRow(const std::vector<WeightType> &row)
+  {
+    if (row.size() != width_)
+      throw std::runtime_error("the row does not have the width of the image");
+    pushRow(row.data());
+  }
+
+  template<class WeightType>
+  void StreamingCTBuilder<WeightType>::pushRow(const WeightType *row)
+  {
+    addRowNodes(row);
+    connectFrontier();
+    numberOfRows_++;
+    hasFrontier_ = true;
+    emitFinalNodes(false);
+  }
+
+  template<class WeightType>
+  void StreamingCTBuilder<WeightType>::finish()
+  {
+    emitFinalNodes(true);
+    numberOfRows_ = 0;
+    hasFrontier_ = false;
+  }
+
+  template<class WeightType>
+  void StreamingCTBuilder<WeightType>::addRowNodes(const WeightType *row)
+  {
+    // 1D tree of the row: "stack" holds the nodes of the path from the
+    // root to the last pixel, the deepest on top.
+    const uint64 y = numberOfRows_;
+    stack_.clear();
+    for (uint32 x = 0; x < width_; x++) {
+      WeightType v = row[x];
+      uint32 last = UNDEF;
+      while (!stack_.empty() && isDeeper(level_[stack_.back()], v)) {
+        uint32 e = stack_.back();
+        stack_.pop_back();
+        if (last != UNDEF)
+          parent_[last] = e;
+        last = e;
+      }
+
+      uint32 node;
+      if (!stack_.empty() && level_[stack_.back()] == v) {
+        node = stack_.back();
+        boundingBox_[node].right = x;
+      }
+      else {
+        node = newNode(v);
+        boundingBox_[node] = StreamBox{x, x, y, y};
+        stack_.push_back(node);
+      }
+      if (last != UNDEF)
+        parent_[last] = node;
+
+      area_[node]++;
+      valueSum_[node] += double(v);
+      row_[x] = node;
+    }
+
+    for (uint32 i = 0; i < stack_.size(); i++)
+      parent_[stack_[i]] = i == 0 ? stack_[i] : stack_[i-1];
+  }
+
+  template<class WeightType>
+  void StreamingCTBuilder<WeightType>::connectFrontier()
+  {
+    if (!hasFrontier_)
+      return;
+
+    const int32 reach = connectivity_ == GridConnectivity::Adjacency8C ? 1 : 0;
+    LevelRootMerge<WeightType> merge{parent_, level_, maxTree_};
+    uint32 lastA = UNDEF, lastB = UNDEF;
+    for (uint32 x = 0; x < width_; x++) {
+      for (int32 dx = -reach; dx <= reach; dx++) {
+        int32 nx = int32(x) + dx;
+        if (nx < 0 || nx >= int32(width_))
+          continue;
+
+        // consecutive pixels mostly connect the same pair of nodes.
+        uint32 a = row_[x], b = frontier_[nx];
+        if (a == lastA && b == lastB)
+          continue;
+        merge.connect(a, b);
+        lastA = a;
+        lastB = b;
+      }
+    }
+  }
+
+  template<class WeightType>
+  void StreamingCTBuilder<WeightType>::emitFinalNodes(bool finishing)
+  {
+    // the attributes of the nodes fused by the merge go to their level
+    // roots, and the level roots which are not ancestors of the last row
+    // are final.
+    const uint32 numberOfNodes = parent_.size();
+    root_.resize(numberOfNodes);
+    LevelRootMerge<WeightType> merge{parent_, level_, maxTree_};
+    for (uint32 e = 0; e < numberOfNodes; e++) {
+      root_[e] = merge.levelRoot(e);
+      if (root_[e] != e)
+        fold(e, root_[e]);
+    }
+
+    const uint32 ALIVE = UNDEF - 1;
+    newIndex_.assign(numberOfNodes, UNDEF);
+    if (!finishing) {
+      for (uint32 x = 0; x < width_; x++) {
+        uint32 r = root_[row_[x]];
+        while (r != UNDEF && newIndex_[r] == UNDEF) {
+          newIndex_[r] = ALIVE;
+          r = parent_[r] == r ? UNDEF : root_[parent_[r]];
+        }
+      }
+    }
+
+    final_.clear();
+    for (uint32 e = 0; e < numberOfNodes; e++) {
+      if (root_[e] == e && newIndex_[e] == UNDEF)
+        final_.push_back(e);
+    }
+
+    // a child is deeper than its parent, so it is emitted and folded into
+    // its parent before that one is emitted.
+    std::stable_sort(final_.begin(), final_.end(), [this](uint32 a, uint32 b) {
+      return isDeeper(level_[a], level_[b]);
+    });
+
+    for (uint32 e : final_) {
+      double area = double(area_[e]), level = double(level_[e]);
+      emit_(ComponentType{level_[e], area_[e], boundingBox_[e],
+        maxTree_ ? valueSum_[e] - area * (level - 1.0) : area * (level + 1.0) - valueSum_[e]});
+      if (parent_[e] != e)
+        fold(e, root_[parent_[e]]);
+    }
+
+    // the active level roots are packed at the front, keeping their order.
+    uint32 numberOfActive = 0;
+    for (uint32 e = 0; e < numberOfNodes; e++) {
+      if (newIndex_[e] == ALIVE)
+        newIndex_[e] = numberOfActive++;
+    }
+
+    for (uint32 e = 0; e < numberOfNodes; e++) {
+      uint32 i = newIndex_[e];
+      if (i == UNDEF)
+        continue;
+
+      level_[i] = level_[e];
+      area_[i] = area_[e];
+      valueSum_[i] = valueSum_[e];
+      boundingBox_[i] = boundingBox_[e];
+      parent_[i] = parent_[e] == e ? i : newIndex_[root_[parent_[e]]];
+    }
+
+    parent_.resize(numberOfActive);
+    level_.resize(numberOfActive);
+    area_.resize(numberOfActive);
+    valueSum_.resize(numberOfActive);
+    boundingBox_.resize(numberOfActive);
+
+    frontier_.resize(width_);
+    if (!finishing) {
+      for (uint32 x = 0; x < width_; x++)
+        frontier_[x] = newIndex_[root_[row_[x]]];
+    }
+  }
+
+  template<class WeightType>
+  uint32 StreamingCTBuilder<WeightType>::newNode(WeightType level)
+  {
+    uint32 e = parent_.size();
+    parent_.push_back(e);
+    level_.push_back(level);
+    area_.push_back(0);
+    valueSum_.push_back(0.0);
+    boundingBox_.push_back(StreamBox{});
+    return e;
+  }
+
+  template<class WeightType>
+  void StreamingCTBuilder<WeightType>::fold(uint32 from, uint32 to)
+  {
+    const StreamBox &a = boundingBox_[from];
+    StreamBox &b = boundingBox_[to];
+    b.left = std::min(a.left, b.left);
+    b.right = std::max(a.right, b.right);
+    b.top = std::min(a.top, b.top);
+    b.bottom = std::max(a.bottom, b.bottom);
+    area_[to] += area_[from];
+    valueSum_[to] += valueSum_[from];
+  }
+}
@@ -0,0 +1,504 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+#include "morphotree/core/box.hpp"
+#include "morphotree/core/rasterFile.hpp"
+#include "morphotree/adjacency/adjacency4c.hpp"
+#include "morphotree/adjacency/adjacency8c.hpp"
+#include "morphotree/attributes/areaComputer.hpp"
+#include "morphotree/attributes/volumeComputer.hpp"
+#include "morphotree/attributes/boundingboxComputer.hpp"
+#include "morphotree/tree/mtree.hpp"
+#include "morphotree/tree/levelRootMerge.hpp"
+#include "morphotree/tree/treeFile.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace morphotree
+{
+  template<class WeightType>
+  class TiledTreeBuilder;
+
+  // TiledTree is the max-tree or min-tree of a raster image which does not
+  // fit in memory, built tile by tile by TiledTreeBuilder. The tree of
+  // every tile is stored in a tree file of the spill directory, with the
+  // attribute columns "area" (uint32), "volume" (float) and "xmin", "ymin",
+  // "xmax", "ymax" (int32, the bounding box in image coordinates). A local
+  // node which does not reach the border of its tile is a node of the
+  // global tree as it is, with the attributes of the file. The local nodes
+  // which reach the border, and their ancestors, are merged across the
+  // tiles into the merged nodes, the upper part of the global tree, which
+  // is held in memory with the area, volume and bounding box of its nodes.
+  // The global parent of an unmerged local node is its local parent when
+  // that one is unmerged as well, and the merged node of its local parent
+  // otherwise. Merged nodes are numbered top-down: the root is 0 and
+  // parents come before their children.
+  template<class WeightType>
+  class TiledTree
+  {
+  public:
+    using TileTreeType = MappedTree<WeightType>;
+
+    static const uint32 UndefinedIndex;
+
+    TiledTree(MorphoTreeType type, const Box &domain, UI32Point tileSize,
+      std::string spillDirectory);
+
+    inline MorphoTreeType type() const { return type_; }
+    inline const Box& domain() const { return domain_; }
+    inline UI32Point tileSize() const { return tileSize_; }
+
+    inline uint32 numberOfTileColumns() const { return columns_; }
+    inline uint32 numberOfTileRows() const { return rows_; }
+    inline uint32 numberOfTiles() const { return columns_ * rows_; }
+
+    // tiles are numbered row by row.
+    Box tileBox(uint32 t) const;
+    std::string tileFilename(uint32 t) const;
+    inline TileTreeType tileTree(uint32 t) const { return TileTreeType{tileFilename(t)}; }
+
+    inline uint32 numberOfMergedNodes() const { return parent_.size(); }
+    inline uint32 parent(uint32 mergedId) const { return parent_[mergedId]; }
+    inline WeightType level(uint32 mergedId) const { return level_[mergedId]; }
+    inline uint64 area(uint32 mergedId) const { return area_[mergedId]; }
+    inline double volume(uint32 mergedId) const { return volume_[mergedId]; }
+    inline const Box& boundingBox(uint32 mergedId) const { return boundingBox_[mergedId]; }
+
+    inline const std::vector<uint32>& parents() const { return parent_; }
+    inline const std::vector<WeightType>& levels() const { return level_; }
+    inline const std::vector<uint64>& areas() const { return area_; }
+    inline const std::vector<double>& volumes() const { return volume_; }
+    inline const std::vector<Box>& boundingBoxes() const { return boundingBox_; }
+
+    // merged node which contains the node "localId" of the tree of tile
+    // "t", or UndefinedIndex if that node is not merged.
+    uint32 mergedNode(uint32 t, uint32 localId) const;
+
+    friend class TiledTreeBuilder<WeightType>;
+
+  private:
+    MorphoTreeType type_;
+    Box domain_;
+    UI32Point tileSize_;
+    std::string spillDirectory_;
+    uint32 columns_;
+    uint32 rows_;
+
+    std::vector<uint32> parent_;
+    std::vector<WeightType> level_;
+    std::vector<uint64> area_;
+    std::vector<double> volume_;
+    std::vector<Box> boundingBox_;
+
+    // merged local nodes of every tile (in increasing order) and the
+    // merged nodes which contain them.
+    std::vector<std::vector<uint32>> tileNodes_;
+    std::vector<std::vector<uint32>> tileMergedNodes_;
+  };
+
+  // TiledTreeBuilder builds a TiledTree reading one tile of the raster at a
+  // time. The tree of each tile is built in memory and spilled to disk;
+  // what is kept are the elements, the local nodes which reach the border
+  // of their tile and their ancestors, with the area, sum of values and
+  // bounding box of the part of their subtree which is not in other
+  // elements. The elements of neighbouring tiles are connected along the
+  // edges crossing the tile borders by LevelRootMerge (Wilkinson et al.),
+  // so only the last row of tiles and the last tile are needed to find
+  // those edges. Area and sum of values are additive
+  // and the bounding boxes are united, so the attributes of the merged
+  // nodes are accumulated from the elements once all tiles are merged; the
+  // volume, as computed by VolumeComputer, follows from them.
+  template<class WeightType>
+  class TiledTreeBuilder
+  {
+  public:
+    using TiledTreeType = TiledTree<WeightType>;
+
+    TiledTreeBuilder(UI32Point tileSize, std::string spillDirectory,
+      GridConnectivity connectivity = GridConnectivity::Adjacency4C);
+
+    TiledTreeType buildMaxTree(RasterFile &file);
+    TiledTreeType buildMinTree(RasterFile &file);
+    TiledTreeType build(MorphoTreeType type, RasterFile &file);
+
+  private:
+    static const uint32 UNDEF;
+
+    void processTile(TiledTreeType &tree, RasterFile &file, uint32 t);
+    void addElements(TiledTreeType &tree, uint32 t, const MorphologicalTree<WeightType> &localTree,
+      const Box &box);
+    void connectTile(const MorphologicalTree<WeightType> &localTree, const Box &box);
+    void finish(TiledTreeType &tree);
+
+    inline bool isDeeper(WeightType a, WeightType b) const { return maxTree_ ? a > b : a < b; }
+    inline uint32 borderElement(const MorphologicalTree<WeightType> &localTree, uint32 width,
+      uint32 x, uint32 y) const;
+
+  private:
+    UI32Point tileSize_;
+    std::string spillDirectory_;
+    GridConnectivity connectivity_;
+    bool maxTree_;
+
+    std::vector<WeightType> f_;
+    std::vector<double> sum_;
+    std::vector<uint32> elementOf_;
+
+    // elements of the tiles read so far.
+    std::vector<uint32> parent_;
+    std::vector<WeightType> level_;
+    std::vector<uint64> area_;
+    std::vector<double> valueSum_;
+    std::vector<Box> boundingBox_;
+
+    // elements of the last row of the previous row of tiles ("above"), of
+    // the last row of the current row of tiles ("below") and of the last
+    // column of the previous tile ("left").
+    std::vector<uint32> above_;
+    std::vector<uint32> below_;
+    std::vector<uint32> left_;
+  };
+
+  // ===================== [ IMPLEMENTATION ] ==================================
+  template<class WeightType>
+  const uint32 TiledTree<WeightType>::UndefinedIndex = std::numeric_limits<uint32>::max();
+
+  template<class WeightType>
+  const uint32 TiledTreeBuilder<WeightType>::UNDEF = std::numeric_limits<uint32>::max();
+
+  namespace tiledtree
+  {
+    inline Box unite(const Box &a, const Box &b)
+    {
+      return Box::fromCorners(
+        I32Point{std::min(a.left(), b.left()), std::min(a.top(), b.top())},
+        I32Point{std::max(a.right(), b.right()), std::max(a.bottom(), b.bottom())});
+    }
+  }
+
+  template<class WeightType>
+  TiledTree<WeightType>::TiledTree(MorphoTreeType type, const Box &domain, UI32Point tileSize,
+    std::string spillDirectory)
+    :type_{type}, domain_{domain}, tileSize_{tileSize}, spillDirectory_{std::move(spillDirectory)}
+  {
+    if (tileSize.width() == 0 || tileSize.height() == 0)
+      throw std::runtime_error("the tiles must not be empty");
+
+    columns_ = (domain.width() + tileSize.width() - 1) / tileSize.width();
+    rows_ = (domain.height() + tileSize.height() - 1) / tileSize.height();
+    tileNodes_.resize(numberOfTiles());
+    tileMergedNodes_.resize(numberOfTiles());
+  }
+
+  template<class WeightType>
+  Box TiledTree<WeightType>::tileBox(uint32 t) const
+  {
+    uint32 x = (t % columns_) * tileSize_.width();
+    uint32 y = (t / columns_) * tileSize_.height();
+    return Box::fromSize(I32Point{domain_.left() + int32(x), domain_.top() + int32(y)},
+      UI32Point{std::min(tileSize_.width(), domain_.width() - x),
+                std::min(tileSize_.height(), domain_.height() - y)});
+  }
+
+  template<class WeightType>
+  std::string TiledTree<WeightType>::tileFilename(uint32 t) const
+  {
+    return spillDirectory_ + "/tile_" + std::to_string(t) + ".mtree";
+  }
+
+  template<class WeightType>
+  uint32 TiledTree<WeightType>::mergedNode(uint32 t, uint32 localId) const
+  {
+    const std::vector<uint32> &nodes = tileNodes_[t];
+    auto it = std::lower_bound(nodes.begin(), nodes.end(), localId);
+    if (it == nodes.end() || *it != localId)
+      return UndefinedIndex;
+    return tileMergedNodes_[t][it - nodes.begin()];
+  }
+
+  template<class WeightType>
+  TiledTreeBuilder<WeightType>::TiledTreeBuilder(UI32Point tileSize, std::string spillDirectory,
+    GridConnectivity connectivity)
+    :tileSize_{tileSize}, spillDirectory_{std::move(spillDirectory)}, connectivity_{connectivity},
+     maxTree_{true}
+  {}
+
+  template<class WeightType>
+  TiledTree<WeightType> TiledTreeBuilder<WeightType>::buildMaxTree(RasterFile &file)
+  {
+    return build(MorphoTreeType::MaxTree, file);
+  }
+
+  template<class WeightType>
+  TiledTree<WeightType> TiledTreeBuilder<WeightType>::buildMinTree(RasterFile &file)
+  {
+    return build(MorphoTreeType::MinTree, file);
+  }
+
+  template<class WeightType>
+  TiledTree<WeightType> TiledTreeBuilder<WeightType>::build(MorphoTreeType type, RasterFile &file)
+  {
+    if (type != MorphoTreeType::MaxTree && type != MorphoTreeType::MinTree)
+      throw std::runtime_error("TiledTreeBuilder builds max-trees and min-trees only");
+
+    TiledTreeType tree{type, file.domain(), tileSize_, spillDirectory_};
+    maxTree_ = type == MorphoTreeType::MaxTree;
+    parent_.clear();
+    level_.clear();
+    area_.clear();
+    valueSum_.clear();
+    boundingBox_.clear();
+    above_.assign(file.width(), UNDEF);
+    below_.assign(file.width(), UNDEF);
+    left_.assign(tileSize_.height(), UNDEF);
+
+    for (uint32 t = 0; t < tree.numberOfTiles(); t++) {
+      processTile(tree, file, t);
+      if ((t + 1) % tree.numberOfTileColumns() == 0)
+        std::swap(above_, below_);
+    }
+
+    finish(tree);
+    return tree;
+  }
+
+  template<class WeightType>
+  void TiledTreeBuilder<WeightType>::processTile(TiledTreeType &tree, RasterFile &file, uint32 t)
+  {
+    Box box = tree.tileBox(t);
+    file.read(box, f_);
+
+    Box localDomain = Box::fromSize(box.size());
+    std::shared_ptr<Adjacency> adj;
+    if (connectivity_ == GridConnectivity::Adjacency8C)
+      adj = std::make_shared<Adjacency8C>(localDomain);
+    else
+      adj = std::make_shared<Adjacency4C>(localDomain);
+
+    MorphologicalTree<WeightType> localTree = maxTree_ ? morphotree::buildMaxTree(f_, adj)
+                                                       : morphotree::buildMinTree(f_, adj);
+
+    std::vector<uint32> area = AreaComputer<WeightType>().computeAttribute(localTree);
+    std::vector<float> volume = VolumeComputer<WeightType>().computeAttribute(localTree);
+    std::vector<Box> bbox = BoundingBoxComputer<WeightType>(box).computeAttribute(localTree);
+
+    const uint32 numberOfNodes = localTree.numberOfNodes();
+    std::vector<int32> xmin(numberOfNodes), ymin(numberOfNodes), xmax(numberOfNodes),
+      ymax(numberOfNodes);
+    for (uint32 id = 0; id < numberOfNodes; id++) {
+      xmin[id] = bbox[id].left();
+      ymin[id] = bbox[id].top();
+      xmax[id] = bbox[id].right();
+      ymax[id] = bbox[id].bottom();
+    }
+
+    TreeFileWriter<WeightType> writer{localTree, box};
+    writer.addAttribute("area", area);
+    writer.addAttribute("volume", volume);
+    writer.addAttribute("xmin", xmin);
+    writer.addAttribute("ymin", ymin);
+    writer.addAttribute("xmax", xmax);
+    writer.addAttribute("ymax", ymax);
+    writer.write(tree.tileFilename(t));
+
+    // sum of the values of the subtree of every local node.
+    sum_.assign(numberOfNodes, 0.0);
+    for (uint32 id = numberOfNodes; id-- > 0; ) {
+      sum_[id] += double(localTree.level(id)) * localTree.numberOfCNPs(id);
+      if (id > 0)
+        sum_[localTree.parent(id)] += sum_[id];
+    }
+
+    addElements(tree, t, localTree, box);
+    for (uint32 id : tree.tileNodes_[t]) {
+      uint32 e = elementOf_[id];
+      area_[e] += area[id];
+      valueSum_[e] += sum_[id];
+      boundingBox_[e] = bbox[id];
+      if (id > 0) {
+        uint32 pe = elementOf_[localTree.parent(id)];
+        area_[pe] -= area[id];
+        valueSum_[pe] -= sum_[id];
+      }
+    }
+
+    connectTile(localTree, box);
+  }
+
+  template<class WeightType>
+  void TiledTreeBuilder<WeightType>::addElements(TiledTreeType &tree, uint32 t,
+    const MorphologicalTree<WeightType> &localTree, const Box &box)
+  {
+    // the nodes of the border pixels and their ancestors are marked, then
+    // numbered as elements top-down, so parents get elements first.
+    const uint32 numberOfNodes = localTree.numberOfNodes();
+    const uint32 MARKED = UNDEF - 1;
+    const uint32 w = box.width(), h = box.height();
+    elementOf_.assign(numberOfNodes, UNDEF);
+
+    auto mark = [&](uint32 x, uint32 y) {
+      uint32 id = localTree.cmap()[y * w + x];
+      while (id != UNDEF && elementOf_[id] == UNDEF) {
+        elementOf_[id] = MARKED;
+        id = localTree.parent(id);
+      }
+    };
+
+    for (uint32 x = 0; x < w; x++) {
+      mark(x, 0);
+      mark(x, h - 1);
+    }
+    for (uint32 y = 0; y < h; y++) {
+      mark(0, y);
+      mark(w - 1, y);
+    }
+
+    std::vector<uint32> &nodes = tree.tileNodes_[t];
+    for (uint32 id = 0; id < numberOfNodes; id++) {
+      if (elementOf_[id] != MARKED)
+        continue;
+
+      uint32 e = parent_.size();
+      elementOf_[id] = e;
+      nodes.push_back(id);
+      parent_.push_back(id == 0 ? e : elementOf_[localTree.parent(id)]);
+      level_.push_back(localTree.level(id));
+      area_.push_back(0);
+      valueSum_.push_back(0.0);
+      boundingBox_.push_back(Box());
+    }
+  }
+
+  template<class WeightType>
+  void TiledTreeBuilder<WeightType>::connectTile(const MorphologicalTree<WeightType> &localTree,
+    const Box &box)
+  {
+    const uint32 w = box.width(), h = box.height();
+    const int32 reach = connectivity_ == GridConnectivity::Adjacency8C ? 1 : 0;
+    const int32 imageWidth = above_.size();
+    LevelRootMerge<WeightType> merge{parent_, level_, maxTree_};
+    uint32 lastA = UNDEF, lastB = UNDEF;
+
+    // consecutive border pixels mostly connect the same pair of elements.
+    auto connectOnce = [&](uint32 a, uint32 b) {
+      if (a == lastA && b == lastB)
+        return;
+      merge.connect(a, b);
+      lastA = a;
+      lastB = b;
+    };
+
+    if (box.top() > 0) {
+      for (uint32 x = 0; x < w; x++) {
+        uint32 e = borderElement(localTree, w, x, 0);
+        for (int32 dx = -reach; dx <= reach; dx++) {
+          int32 nx = box.left() + int32(x) + dx;
+          if (nx >= 0 && nx < imageWidth)
+            connectOnce(e, above_[nx]);
+        }
+      }
+    }
+
+    if (box.left() > 0) {
+      for (uint32 y = 0; y < h; y++) {
+        uint32 e = borderElement(localTree, w, 0, y);
+        for (int32 dy = -reach; dy <= reach; dy++) {
+          int32 ny = int32(y) + dy;
+          if (ny >= 0 && ny < int32(h))
+            connectOnce(e, left_[ny]);
+        }
+      }
+    }
+
+    for (uint32 y = 0; y < h; y++)
+      left_[y] = borderElement(localTree, w, w - 1, y);
+    for (uint32 x = 0; x < w; x++)
+      below_[box.left() + x] = borderElement(localTree, w, x, h - 1);
+  }
+
+  template<class WeightType>
+  uint32 TiledTreeBuilder<WeightType>::borderElement(
+    const MorphologicalTree<WeightType> &localTree, uint32 width, uint32 x, uint32 y) const
+  {
+    return elementOf_[localTree.cmap()[y * width + x]];
+  }
+
+  template<class WeightType>
+  void TiledTreeBuilder<WeightType>::finish(TiledTreeType &tree)
+  {
+    // the level roots of the elements are the merged nodes, numbered from
+    // the shallowest level on, so parents come before their children.
+    const uint32 numberOfElements = parent_.size();
+    std::vector<uint32> root(numberOfElements);
+    std::vector<uint32> roots;
+    LevelRootMerge<WeightType> merge{parent_, level_, maxTree_};
+    for (uint32 e = 0; e < numberOfElements; e++) {
+      root[e] = merge.levelRoot(e);
+      if (root[e] == e)
+        roots.push_back(e);
+    }
+
+    std::stable_sort(roots.begin(), roots.end(), [this](uint32 a, uint32 b) {
+      return isDeeper(level_[b], level_[a]);
+    });
+
+    const uint32 numberOfNodes = roots.size();
+    std::vector<uint32> newId(numberOfElements, UNDEF);
+    for (uint32 id = 0; id < numberOfNodes; id++)
+      newId[roots[id]] = id;
+
+    tree.parent_.resize(numberOfNodes);
+    tree.level_.resize(numberOfNodes);
+    tree.area_.assign(numberOfNodes, 0);
+    tree.volume_.assign(numberOfNodes, 0.0);
+    tree.boundingBox_.resize(numberOfNodes);
+    std::vector<double> valueSum(numberOfNodes, 0.0);
+    for (uint32 id = 0; id < numberOfNodes; id++) {
+      uint32 r = roots[id];
+      tree.parent_[id] = parent_[r] == r ? TiledTreeType::UndefinedIndex : newId[root[parent_[r]]];
+      tree.level_[id] = level_[r];
+    }
+
+    for (uint32 e = 0; e < numberOfElements; e++) {
+      uint32 id = newId[root[e]];
+      tree.boundingBox_[id] = tree.area_[id] == 0 ? boundingBox_[e]
+                                                  : tiledtree::unite(tree.boundingBox_[id], boundingBox_[e]);
+      tree.area_[id] += area_[e];
+      valueSum[id] += valueSum_[e];
+    }
+
+    for (uint32 id = numberOfNodes; id-- > 1; ) {
+      uint32 pid = tree.parent_[id];
+      tree.area_[pid] += tree.area_[id];
+      valueSum[pid] += valueSum[id];
+      tree.boundingBox_[pid] = tiledtree::unite(tree.boundingBox_[pid], tree.boundingBox_[id]);
+    }
+
+    // the volume of VolumeComputer, the sum of |f(p) - level| + 1 over
+    // the pixels of the node.
+    for (uint32 id = 0; id < numberOfNodes; id++) {
+      double a = double(tree.area_[id]), level = double(tree.level_[id]);
+      tree.volume_[id] = maxTree_ ? valueSum[id] - a * (level - 1.0)
+                                  : a * (level + 1.0) - valueSum[id];
+    }
+
+    uint32 e = 0;
+    for (uint32 t = 0; t < tree.numberOfTiles(); t++) {
+      std::vector<uint32> &merged = tree.tileMergedNodes_[t];
+      merged.resize(tree.tileNodes_[t].size());
+      for (uint32 &id : merged)
+        id = newId[root[e++]];
+    }
+
+    parent_ = std::vector<uint32>();
+    level_ = std::vector<WeightType>();
+    area_ = std::vector<uint64>();
+    valueSum_ = std::vector<double>();
+    boundingBox_ = std::vector<Box>();
+  }
+}
\ No newline at end of file
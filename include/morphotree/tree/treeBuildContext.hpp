@@ -0,0 +1,167 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+#include "morphotree/core/box.hpp"
+#include "morphotree/core/sort.hpp"
+#include "morphotree/core/linkedHierarchicalQueue.hpp"
+#include "morphotree/adjacency/adjacency.hpp"
+#include "morphotree/adjacency/adjacencyDispatch.hpp"
+#include "morphotree/tree/ct_builder.hpp"
+#include "morphotree/tree/flood_ct_builder.hpp"
+#include "morphotree/tree/mtree.hpp"
+#include "morphotree/tree/treeOfShapes/kgrid.hpp"
+#include "morphotree/tree/treeOfShapes/order_image.hpp"
+#include "morphotree/tree/treeOfShapes/tos.hpp"
+
+#include <stdexcept>
+#include <vector>
+#include <memory>
+
+namespace morphotree
+{
+  // TreeBuildContext owns the buffers needed to build the trees of the
+  // images of a fixed domain, e.g. the frames of a video: the builders
+  // with their sort, union-find and flooding buffers, the parent array and
+  // R and, for the tree of shapes, the KGrid, the order image with the
+  // buckets of its queue and the enlarged tree. The trees are rebuilt in
+  // the storage of the given MorphologicalTree, so once the buffers have
+  // grown to the largest number of nodes seen, a build does not allocate.
+  // The max-tree and min-tree are built as by buildMaxTree and buildMinTree
+  // with one thread and NodeOrdering::LevelRoots (flooding for the integer
+  // types of up to 16 bits, sort and union-find otherwise); the tree of
+  // shapes is the one of buildTreeOfShapes.
+  template<class WeightType>
+  class TreeBuildContext
+  {
+  public:
+    TreeBuildContext(const Box &domain);
+
+    inline const Box& domain() const { return domain_; }
+
+    void buildMaxTree(const std::vector<WeightType> &f, std::shared_ptr<Adjacency> adj,
+      MorphologicalTree<WeightType> &tree);
+
+    void buildMinTree(const std::vector<WeightType> &f, std::shared_ptr<Adjacency> adj,
+      MorphologicalTree<WeightType> &tree);
+
+    template<class AdjacencyType, class = RequireAdjacency<AdjacencyType>>
+    void buildMaxTree(const std::vector<WeightType> &f, const AdjacencyType &adj,
+      MorphologicalTree<WeightType> &tree);
+
+    template<class AdjacencyType, class = RequireAdjacency<AdjacencyType>>
+    void buildMinTree(const std::vector<WeightType> &f, const AdjacencyType &adj,
+      MorphologicalTree<WeightType> &tree);
+
+    // WeightType must be an integer type of up to 16 bits.
+    void buildTreeOfShapes(const std::vector<WeightType> &f, MorphologicalTree<WeightType> &tree,
+      I32Point pInfty = I32Point{0,0});
+
+  private:
+    template<class AdjacencyType>
+    void buildComponentTree(MorphoTreeType type, const std::vector<WeightType> &f,
+      const AdjacencyType &adj, MorphologicalTree<WeightType> &tree);
+
+    void checkDomain(const std::vector<WeightType> &f) const;
+
+  private:
+    Box domain_;
+    RadixSorter<WeightType> sorter_;
+    std::vector<uint32> R_;
+    std::vector<uint32> parent_;
+    CTBuilder<WeightType> builder_;
+    FloodCTBuilder<WeightType> floodBuilder_;
+
+    KGrid<WeightType> kgrid_;
+    OrderImageResult<WeightType> orderImage_;
+    LinkedHierarchicalQueue queue_;
+    CTBuilder<uint32> orderBuilder_;
+    MorphologicalTree<WeightType> enlargedTree_;
+    std::vector<uint32> cmap_;
+    std::vector<uint32> nodeParent_;
+    std::vector<WeightType> level_;
+    std::vector<uint32> representative_;
+  };
+
+  // ===================== [ IMPLEMENTATION ] ==================================
+  template<class WeightType>
+  TreeBuildContext<WeightType>::TreeBuildContext(const Box &domain)
+    :domain_{domain}, enlargedTree_{MorphoTreeType::TreeOfShapes}
+  {
+    R_.reserve(domain.numberOfPoints());
+    parent_.reserve(domain.numberOfPoints());
+  }
+
+  template<class WeightType>
+  void TreeBuildContext<WeightType>::buildMaxTree(const std::vector<WeightType> &f,
+    std::shared_ptr<Adjacency> adj, MorphologicalTree<WeightType> &tree)
+  {
+    withStaticAdjacency(*adj, [&](const auto &a) { buildMaxTree(f, a, tree); });
+  }
+
+  template<class WeightType>
+  void TreeBuildContext<WeightType>::buildMinTree(const std::vector<WeightType> &f,
+    std::shared_ptr<Adjacency> adj, MorphologicalTree<WeightType> &tree)
+  {
+    withStaticAdjacency(*adj, [&](const auto &a) { buildMinTree(f, a, tree); });
+  }
+
+  template<class WeightType>
+  template<class AdjacencyType, class>
+  void TreeBuildContext<WeightType>::buildMaxTree(const std::vector<WeightType> &f,
+    const AdjacencyType &adj, MorphologicalTree<WeightType> &tree)
+  {
+    buildComponentTree(MorphoTreeType::MaxTree, f, adj, tree);
+  }
+
+  template<class WeightType>
+  template<class AdjacencyType, class>
+  void TreeBuildContext<WeightType>::buildMinTree(const std::vector<WeightType> &f,
+    const AdjacencyType &adj, MorphologicalTree<WeightType> &tree)
+  {
+    buildComponentTree(MorphoTreeType::MinTree, f, adj, tree);
+  }
+
+  template<class WeightType>
+  template<class AdjacencyType>
+  void TreeBuildContext<WeightType>::buildComponentTree(MorphoTreeType type,
+    const std::vector<WeightType> &f, const AdjacencyType &adj,
+    MorphologicalTree<WeightType> &tree)
+  {
+    checkDomain(f);
+    if (FloodCTBuilder<WeightType>::isSupported()) {
+      if (type == MorphoTreeType::MaxTree)
+        floodBuilder_.buildMaxTree(f, adj, parent_, R_);
+      else
+        floodBuilder_.buildMinTree(f, adj, parent_, R_);
+    }
+    else {
+      if (type == MorphoTreeType::MaxTree)
+        sorter_.sortIncreasing(f, R_);
+      else
+        sorter_.sortDecreasing(f, R_);
+      builder_.build(f, adj, R_, parent_);
+    }
+    tree.assign(type, f, parent_, R_);
+  }
+
+  template<class WeightType>
+  void TreeBuildContext<WeightType>::buildTreeOfShapes(const std::vector<WeightType> &f,
+    MorphologicalTree<WeightType> &tree, I32Point pInfty)
+  {
+    checkDomain(f);
+    kgrid_.assign(domain_, f);
+    computeOrderImage(domain_, f, kgrid_, orderImage_, queue_, pInfty);
+    orderBuilder_.build(orderImage_.orderImg, *kgrid_.adj(), orderImage_.R, parent_);
+    enlargedTree_.assign(MorphoTreeType::TreeOfShapes, orderImage_.flattern, parent_,
+      orderImage_.R);
+    emergeTreeOfShapes(kgrid_, enlargedTree_, cmap_, nodeParent_, level_, representative_);
+    tree.swapAssign(MorphoTreeType::TreeOfShapes, cmap_, nodeParent_, level_, representative_);
+  }
+
+  template<class WeightType>
+  void TreeBuildContext<WeightType>::checkDomain(const std::vector<WeightType> &f) const
+  {
+    if (f.size() != domain_.numberOfPoints())
+      throw std::runtime_error("TreeBuildContext: the image does not match the domain of the context.");
+  }
+}
\ No newline at end of file
@@ -0,0 +1,413 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+#include "morphotree/core/box.hpp"
+#include "morphotree/core/span.hpp"
+#include "morphotree/core/mappedFile.hpp"
+#include "morphotree/tree/mtree.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace morphotree
+{
+  // Binary tree file (version 1). All values are stored in the native byte
+  // order of the writer:
+  //   TreeFileHeader
+  //   TreeFileAttribute[numberOfAttributes]
+  //   parent[n], level[n], representative[n], childOffset[n+1],
+  //   children[n-1], cnpOffset[n+1], cnps[p], cmap[p], attribute columns,
+  // where n is the number of nodes and p is the number of pixels. Every
+  // array starts at an 8-byte aligned offset (given by the header), so a
+  // mapped file is read in place.
+  struct TreeFileHeader
+  {
+    char magic[8];
+    uint32 version;
+    uint32 weightType;
+    uint32 treeType;
+    uint32 flags;
+    int32 left;
+    int32 top;
+    uint32 width;
+    uint32 height;
+    uint32 numberOfNodes;
+    uint32 numberOfPixels;
+    uint32 numberOfAttributes;
+    uint32 reserved;
+    std::uint64_t parentOffset;
+    std::uint64_t levelOffset;
+    std::uint64_t representativeOffset;
+    std::uint64_t childOffsetOffset;
+    std::uint64_t childrenOffset;
+    std::uint64_t cnpOffsetOffset;
+    std::uint64_t cnpsOffset;
+    std::uint64_t cmapOffset;
+  };
+
+  struct TreeFileAttribute
+  {
+    char name[48];
+    uint32 valueType;
+    uint32 reserved;
+    std::uint64_t offset;
+  };
+
+  static_assert(sizeof(TreeFileHeader) == 120, "unexpected tree file header layout");
+  static_assert(sizeof(TreeFileAttribute) == 64, "unexpected tree file attribute layout");
+
+  // codes of the value types which can be stored in a tree file.
+  template<class T>
+  struct TreeFileValueType;
+
+  template<> struct TreeFileValueType<uint8> { static const uint32 code = 1; };
+  template<> struct TreeFileValueType<int8> { static const uint32 code = 2; };
+  template<> struct TreeFileValueType<uint16> { static const uint32 code = 3; };
+  template<> struct TreeFileValueType<int16> { static const uint32 code = 4; };
+  template<> struct TreeFileValueType<uint32> { static const uint32 code = 5; };
+  template<> struct TreeFileValueType<int32> { static const uint32 code = 6; };
+  template<> struct TreeFileValueType<float> { static const uint32 code = 7; };
+  template<> struct TreeFileValueType<double> { static const uint32 code = 8; };
+
+  // TreeFileWriter streams a tree, its domain and optional attribute
+  // columns (one value per node) to a tree file. The tree and the
+  // attributes are not copied: they must be alive when write is called.
+  template<class WeightType>
+  class TreeFileWriter
+  {
+  public:
+    using TreeType = MorphologicalTree<WeightType>;
+
+    TreeFileWriter(const TreeType &tree, const Box &domain);
+
+    template<class AttrType>
+    void addAttribute(const std::string &name, const std::vector<AttrType> &attr);
+
+    void write(std::ostream &out) const;
+    void write(const std::string &filename) const;
+
+  private:
+    struct Column
+    {
+      std::string name;
+      uint32 valueType;
+      const char *data;
+      std::size_t bytes;
+    };
+
+  private:
+    const TreeType *tree_;
+    Box domain_;
+    std::vector<Column> columns_;
+  };
+
+  // MappedTree is a read-only tree stored in a tree file and mapped into
+  // memory: its arrays are read in place. toTree() builds a
+  // MorphologicalTree from it.
+  template<class WeightType>
+  class MappedTree
+  {
+  public:
+    using TreeType = MorphologicalTree<WeightType>;
+
+    MappedTree(const std::string &filename);
+
+    inline MorphoTreeType type() const { return static_cast<MorphoTreeType>(header_->treeType); }
+    inline bool isDepthFirst() const { return (header_->flags & 1) != 0; }
+    Box domain() const;
+
+    inline uint32 numberOfNodes() const { return header_->numberOfNodes; }
+    inline uint32 numberOfPixels() const { return header_->numberOfPixels; }
+
+    inline uint32 parent(uint32 nodeId) const { return parents()[nodeId]; }
+    inline WeightType level(uint32 nodeId) const { return levels()[nodeId]; }
+    inline uint32 representative(uint32 nodeId) const { return representatives()[nodeId]; }
+    Span<const uint32> children(uint32 nodeId) const;
+    Span<const uint32> cnps(uint32 nodeId) const;
+
+    inline Span<const uint32> parents() const { return section<uint32>(header_->parentOffset, numberOfNodes()); }
+    inline Span<const WeightType> levels() const { return section<WeightType>(header_->levelOffset, numberOfNodes()); }
+    inline Span<const uint32> representatives() const { return section<uint32>(header_->representativeOffset, numberOfNodes()); }
+    inline Span<const uint32> cmap() const { return section<uint32>(header_->cmapOffset, numberOfPixels()); }
+
+    bool hasAttribute(const std::string &name) const;
+
+    // attribute column "name" (throws if there is no such column or if it
+    // holds another value type).
+    template<class AttrType>
+    Span<const AttrType> attribute(const std::string &name) const;
+
+    std::vector<WeightType> reconstructImage() const;
+    TreeType toTree() const;
+
+  private:
+    template<class T>
+    inline Span<const T> section(std::uint64_t offset, std::size_t size) const;
+
+    const TreeFileAttribute* findAttribute(const std::string &name) const;
+    void validate(const std::string &filename);
+
+  private:
+    MappedFile file_;
+    const TreeFileHeader *header_;
+    const TreeFileAttribute *attributes_;
+  };
+
+  // ===================== [ IMPLEMENTATION ] ==================================
+  namespace treefile
+  {
+    const char Magic[8] = {'M', 'T', 'R', 'E', 'E', 'B', 'I', 'N'};
+    const uint32 Version = 1;
+    const uint32 DepthFirstFlag = 1;
+
+    inline std::uint64_t align(std::uint64_t offset) { return (offset + 7) & ~std::uint64_t(7); }
+
+    inline void pad(std::ostream &out, std::uint64_t &pos, std::uint64_t offset)
+    {
+      const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+      out.write(zeros, offset - pos);
+      pos = offset;
+    }
+  }
+
+  template<class WeightType>
+  TreeFileWriter<WeightType>::TreeFileWriter(const TreeType &tree, const Box &domain)
+    :tree_{&tree}, domain_{domain}
+  {}
+
+  template<class WeightType>
+  template<class AttrType>
+  void TreeFileWriter<WeightType>::addAttribute(const std::string &name,
+    const std::vector<AttrType> &attr)
+  {
+    if (name.size() >= sizeof(TreeFileAttribute::name))
+      throw std::runtime_error("tree file attribute name is too long: " + name);
+    if (attr.size() != tree_->numberOfNodes())
+      throw std::runtime_error("tree file attribute " + name + " does not have one value per node");
+
+    columns_.push_back(Column{name, TreeFileValueType<AttrType>::code,
+      reinterpret_cast<const char*>(attr.data()), attr.size() * sizeof(AttrType)});
+  }
+
+  template<class WeightType>
+  void TreeFileWriter<WeightType>::write(std::ostream &out) const
+  {
+    using treefile::align;
+    const TreeType &tree = *tree_;
+
+    TreeFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, treefile::Magic, sizeof(header.magic));
+    header.version = treefile::Version;
+    header.weightType = TreeFileValueType<WeightType>::code;
+    header.treeType = static_cast<uint32>(tree.type());
+    header.flags = tree.isDepthFirst() ? treefile::DepthFirstFlag : 0;
+    header.left = domain_.left();
+    header.top = domain_.top();
+    header.width = domain_.width();
+    header.height = domain_.height();
+    header.numberOfNodes = tree.numberOfNodes();
+    header.numberOfPixels = tree.numberOfCNPs();
+    header.numberOfAttributes = columns_.size();
+
+    // offsets of the arrays
+    std::uint64_t pos = sizeof(TreeFileHeader) + columns_.size() * sizeof(TreeFileAttribute);
+    auto place = [&pos](std::uint64_t &offset, std::size_t bytes) {
+      offset = align(pos);
+      pos = offset + bytes;
+    };
+    place(header.parentOffset, tree.parents().size() * sizeof(uint32));
+    place(header.levelOffset, tree.levels().size() * sizeof(WeightType));
+    place(header.representativeOffset, tree.representatives().size() * sizeof(uint32));
+    place(header.childOffsetOffset, tree.childOffsets().size() * sizeof(uint32));
+    place(header.childrenOffset, tree.packedChildren().size() * sizeof(uint32));
+    place(header.cnpOffsetOffset, tree.cnpOffsets().size() * sizeof(uint32));
+    place(header.cnpsOffset, tree.packedCNPs().size() * sizeof(uint32));
+    place(header.cmapOffset, tree.cmap().size() * sizeof(uint32));
+
+    std::vector<TreeFileAttribute> attributes(columns_.size());
+    for (uint32 i = 0; i < columns_.size(); i++) {
+      std::memset(&attributes[i], 0, sizeof(TreeFileAttribute));
+      std::memcpy(attributes[i].name, columns_[i].name.c_str(), columns_[i].name.size());
+      attributes[i].valueType = columns_[i].valueType;
+      place(attributes[i].offset, columns_[i].bytes);
+    }
+
+    // streaming
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(attributes.data()),
+      attributes.size() * sizeof(TreeFileAttribute));
+
+    pos = sizeof(TreeFileHeader) + columns_.size() * sizeof(TreeFileAttribute);
+    auto writeSection = [&out, &pos](std::uint64_t offset, const char *data, std::size_t bytes) {
+      treefile::pad(out, pos, offset);
+      out.write(data, bytes);
+      pos += bytes;
+    };
+    auto writeVector = [&writeSection](std::uint64_t offset, const auto &v) {
+      writeSection(offset, reinterpret_cast<const char*>(v.data()),
+        v.size() * sizeof(typename std::decay<decltype(v)>::type::value_type));
+    };
+    writeVector(header.parentOffset, tree.parents());
+    writeVector(header.levelOffset, tree.levels());
+    writeVector(header.representativeOffset, tree.representatives());
+    writeVector(header.childOffsetOffset, tree.childOffsets());
+    writeVector(header.childrenOffset, tree.packedChildren());
+    writeVector(header.cnpOffsetOffset, tree.cnpOffsets());
+    writeVector(header.cnpsOffset, tree.packedCNPs());
+    writeVector(header.cmapOffset, tree.cmap());
+    for (uint32 i = 0; i < columns_.size(); i++) {
+      writeSection(attributes[i].offset, columns_[i].data, columns_[i].bytes);
+    }
+
+    if (!out)
+      throw std::runtime_error("could not write the tree file");
+  }
+
+  template<class WeightType>
+  void TreeFileWriter<WeightType>::write(const std::string &filename) const
+  {
+    std::ofstream out{filename, std::ios::binary};
+    if (!out)
+      throw std::runtime_error("could not open " + filename);
+    write(out);
+  }
+
+  template<class WeightType>
+  MappedTree<WeightType>::MappedTree(const std::string &filename)
+    :file_{filename}, header_{nullptr}, attributes_{nullptr}
+  {
+    validate(filename);
+  }
+
+  template<class WeightType>
+  void MappedTree<WeightType>::validate(const std::string &filename)
+  {
+    if (file_.size() < sizeof(TreeFileHeader))
+      throw std::runtime_error(filename + " is not a tree file");
+
+    const TreeFileHeader *header = reinterpret_cast<const TreeFileHeader*>(file_.data());
+    if (std::memcmp(header->magic, treefile::Magic, sizeof(header->magic)) != 0)
+      throw std::runtime_error(filename + " is not a tree file");
+    if (header->version != treefile::Version)
+      throw std::runtime_error(filename + ": unsupported tree file version");
+    if (header->weightType != TreeFileValueType<WeightType>::code)
+      throw std::runtime_error(filename + ": the tree file holds another weight type");
+
+    const std::uint64_t n = header->numberOfNodes;
+    const std::uint64_t p = header->numberOfPixels;
+    const std::uint64_t attributesEnd = sizeof(TreeFileHeader) +
+      header->numberOfAttributes * sizeof(TreeFileAttribute);
+    bool valid = attributesEnd <= file_.size();
+    auto check = [this, &valid](std::uint64_t offset, std::uint64_t bytes) {
+      valid = valid && offset % 8 == 0 && offset <= file_.size() && bytes <= file_.size() - offset;
+    };
+    check(header->parentOffset, n * sizeof(uint32));
+    check(header->levelOffset, n * sizeof(WeightType));
+    check(header->representativeOffset, n * sizeof(uint32));
+    check(header->childOffsetOffset, (n + 1) * sizeof(uint32));
+    check(header->childrenOffset, (n > 0 ? n - 1 : 0) * sizeof(uint32));
+    check(header->cnpOffsetOffset, (n + 1) * sizeof(uint32));
+    check(header->cnpsOffset, p * sizeof(uint32));
+    check(header->cmapOffset, p * sizeof(uint32));
+    if (!valid)
+      throw std::runtime_error(filename + ": truncated tree file");
+
+    header_ = header;
+    attributes_ = reinterpret_cast<const TreeFileAttribute*>(file_.data() + sizeof(TreeFileHeader));
+  }
+
+  template<class WeightType>
+  template<class T>
+  Span<const T> MappedTree<WeightType>::section(std::uint64_t offset, std::size_t size) const
+  {
+    return Span<const T>{reinterpret_cast<const T*>(file_.data() + offset), size};
+  }
+
+  template<class WeightType>
+  Box MappedTree<WeightType>::domain() const
+  {
+    return Box::fromSize(I32Point{header_->left, header_->top},
+      UI32Point{header_->width, header_->height});
+  }
+
+  template<class WeightType>
+  Span<const uint32> MappedTree<WeightType>::children(uint32 nodeId) const
+  {
+    Span<const uint32> offset = section<uint32>(header_->childOffsetOffset, numberOfNodes() + 1);
+    Span<const uint32> children = section<uint32>(header_->childrenOffset,
+      numberOfNodes() > 0 ? numberOfNodes() - 1 : 0);
+    return Span<const uint32>{children.data() + offset[nodeId], children.data() + offset[nodeId+1]};
+  }
+
+  template<class WeightType>
+  Span<const uint32> MappedTree<WeightType>::cnps(uint32 nodeId) const
+  {
+    Span<const uint32> offset = section<uint32>(header_->cnpOffsetOffset, numberOfNodes() + 1);
+    Span<const uint32> cnps = section<uint32>(header_->cnpsOffset, numberOfPixels());
+    return Span<const uint32>{cnps.data() + offset[nodeId], cnps.data() + offset[nodeId+1]};
+  }
+
+  template<class WeightType>
+  const TreeFileAttribute* MappedTree<WeightType>::findAttribute(const std::string &name) const
+  {
+    for (uint32 i = 0; i < header_->numberOfAttributes; i++) {
+      const TreeFileAttribute &attr = attributes_[i];
+      if (std::strncmp(attr.name, name.c_str(), sizeof(attr.name)) == 0)
+        return &attr;
+    }
+    return nullptr;
+  }
+
+  template<class WeightType>
+  bool MappedTree<WeightType>::hasAttribute(const std::string &name) const
+  {
+    return findAttribute(name) != nullptr;
+  }
+
+  template<class WeightType>
+  template<class AttrType>
+  Span<const AttrType> MappedTree<WeightType>::attribute(const std::string &name) const
+  {
+    const TreeFileAttribute *attr = findAttribute(name);
+    if (attr == nullptr)
+      throw std::runtime_error("the tree file has no attribute " + name);
+    if (attr->valueType != TreeFileValueType<AttrType>::code)
+      throw std::runtime_error("the tree file attribute " + name + " holds another value type");
+
+    const std::uint64_t bytes = std::uint64_t(numberOfNodes()) * sizeof(AttrType);
+    if (attr->offset % 8 != 0 || attr->offset > file_.size() || bytes > file_.size() - attr->offset)
+      throw std::runtime_error("truncated tree file attribute " + name);
+
+    return section<AttrType>(attr->offset, numberOfNodes());
+  }
+
+  template<class WeightType>
+  std::vector<WeightType> MappedTree<WeightType>::reconstructImage() const
+  {
+    Span<const WeightType> level = levels();
+    Span<const uint32> cm = cmap();
+    std::vector<WeightType> f(cm.size());
+    const int numberOfPixels = static_cast<int>(cm.size());
+
+    #pragma omp parallel for
+    for (int idx = 0; idx < numberOfPixels; idx++) {
+      f[idx] = level[cm[idx]];
+    }
+    return f;
+  }
+
+  template<class WeightType>
+  typename MappedTree<WeightType>::TreeType MappedTree<WeightType>::toTree() const
+  {
+    TreeType tree{type(), cmap(), parents(), levels(), representatives()};
+    if (isDepthFirst())
+      tree.renumberDepthFirst();
+    return tree;
+  }
+}
\ No newline at end of file
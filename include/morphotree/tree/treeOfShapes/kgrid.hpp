@@ -47,6 +47,11 @@ namespace morphotree
 
     KGrid();
     KGrid(const Box &imgDomain, const std::vector<ValueType> &data);
+
+    // recomputes the grid for another image. The intervals and the
+    // adjacency are reused when the domain has the same size, so the
+    // adjacency returned by adj() before is updated too.
+    void assign(const Box &imgDomain, const std::vector<ValueType> &data);
   
     IntervalType& interval(uint32 idx) { return data_[idx]; }
     IntervalType  interval(uint32 idx) const { return data_[idx]; }
@@ -141,15 +146,27 @@ namespace morphotree
     computeGrid(imgDomain, data);
   }
 
+  template<class ValueType>
+  void KGrid<ValueType>::assign(const Box &imgDomain, const std::vector<ValueType> &data)
+  {
+    imgDomain_ = imgDomain;
+    computeGrid(imgDomain, data);
+  }
+
   template<class ValueType>
   void KGrid<ValueType>::computeGrid(const Box &imgDomain, const std::vector<ValueType> &data)
   {
-    domain_ = Box::fromSize(imgDomain.topleft(), 
+    Box domain = Box::fromSize(imgDomain.topleft(), 
       UI32Point{2*imgDomain.width()-1, 2*imgDomain.height()-1});
+    if (adjU_ && domain.width() == domain_.width() && domain.height() == domain_.height()) {
+      adjU_->clearDiagonalConnections();
+    }
+    else {
+      adjU_ = std::make_shared<AdjacencyUC>(domain);
+    }
+    domain_ = domain;
     data_.resize(domain_.numberOfPoints(), IntervalType{0,0});
 
-    adjU_ = std::make_shared<AdjacencyUC>(domain_);
-
     // Compute interval from 2-faces.
     I32Point p = domain_.topleft();
     for (; p.y() <= domain_.bottom(); p.y() += 2)
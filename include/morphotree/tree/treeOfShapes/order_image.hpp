@@ -1,13 +1,19 @@
 #pragma once 
 
 #include <vector>
+#include <limits>
+#include <utility>
+#include <type_traits>
 
 #include "morphotree/core/box.hpp"
 #include "morphotree/core/alias.hpp"
-#include "morphotree/core/hqueue.hpp"
+#include "morphotree/core/copyCounter.hpp"
+#include "morphotree/core/linkedHierarchicalQueue.hpp"
 #include "morphotree/tree/treeOfShapes/kgrid.hpp"
 
 namespace morphotree {
+  // the arrays given to the constructor are moved in. Copies are counted
+  // by CopyCounter.
   template<class Value>
   struct OrderImageResult
   {
@@ -16,6 +22,11 @@ namespace morphotree {
     OrderImageResult();
     OrderImageResult(std::vector<uint32> porderImg, std::vector<ValueType> pflattern, std::vector<uint32> pR, Box pDomain);
 
+    OrderImageResult(const OrderImageResult<ValueType> &other);
+    OrderImageResult(OrderImageResult<ValueType> &&other) = default;
+    OrderImageResult<ValueType>& operator=(const OrderImageResult<ValueType> &other);
+    OrderImageResult<ValueType>& operator=(OrderImageResult<ValueType> &&other) = default;
+
     std::vector<uint32> orderImg;
     std::vector<uint32> R;
     std::vector<ValueType> flattern;
@@ -30,6 +41,19 @@ namespace morphotree {
     const KGrid<ValueType> &F,
     const I32Point &pInfinity = I32Point{0,0});
 
+  // computes the order image into "res", reusing its arrays and the
+  // buckets of "queue", so that images of the same domain are processed
+  // again without allocating. ValueType must be an integer type of up to
+  // 16 bits.
+  template<class ValueType>
+  void computeOrderImage(
+    const Box &domain,
+    const std::vector<ValueType> &f,
+    const KGrid<ValueType> &F,
+    OrderImageResult<ValueType> &res,
+    LinkedHierarchicalQueue &queue,
+    const I32Point &pInfinity = I32Point{0,0});
+
   // ====================================== [ IMPLEMENTATION ] ============================================
   template<class ValueType>
   OrderImageResult<ValueType>::OrderImageResult()
@@ -38,9 +62,29 @@ namespace morphotree {
   template<class ValueType>
   OrderImageResult<ValueType>::OrderImageResult(std::vector<uint32> porderImg, std::vector<ValueType> pflattern,
     std::vector<uint32> pR, Box pDomain)
-    :orderImg{porderImg}, flattern{pflattern}, R{pR}, domain{pDomain}
+    :orderImg{std::move(porderImg)}, R{std::move(pR)}, flattern{std::move(pflattern)},
+     domain{pDomain}
   {}
 
+  template<class ValueType>
+  OrderImageResult<ValueType>::OrderImageResult(const OrderImageResult<ValueType> &other)
+    :orderImg{other.orderImg}, R{other.R}, flattern{other.flattern}, domain{other.domain}
+  {
+    CopyCounter::increment();
+  }
+
+  template<class ValueType>
+  OrderImageResult<ValueType>& OrderImageResult<ValueType>::operator=(
+    const OrderImageResult<ValueType> &other)
+  {
+    orderImg = other.orderImg;
+    R = other.R;
+    flattern = other.flattern;
+    domain = other.domain;
+    CopyCounter::increment();
+    return *this;
+  }
+
   template<class ValueType>
   OrderImageResult<ValueType> computeOrderImage(
     const Box &domain,
@@ -48,39 +92,62 @@ namespace morphotree {
     const KGrid<ValueType> &F,
     const I32Point &pInfinity)
   {
+    OrderImageResult<ValueType> res;
+    LinkedHierarchicalQueue queue;
+    computeOrderImage(domain, f, F, res, queue, pInfinity);
+    return res;
+  }
+
+  template<class ValueType>
+  void computeOrderImage(
+    const Box &domain,
+    const std::vector<ValueType> &f,
+    const KGrid<ValueType> &F,
+    OrderImageResult<ValueType> &res,
+    LinkedHierarchicalQueue &queue,
+    const I32Point &pInfinity)
+  {
+    static_assert(std::is_integral<ValueType>::value && sizeof(ValueType) <= 2,
+      "computeOrderImage supports integer types of up to 16 bits only.");
+
     const uint32 UNPROCESSED = std::numeric_limits<uint32>::max();
-    const uint32 PROCESSED = std::numeric_limits<uint>::max()-1;
+    const uint32 PROCESSED = std::numeric_limits<uint32>::max()-1;
+    const int32 minValue = std::numeric_limits<ValueType>::min();
+    const uint32 numberOfLevels = int32(std::numeric_limits<ValueType>::max()) - minValue + 1;
 
-    using GridType = decltype(F);
-    using QueueType = HQueue<ValueType, uint32>;
-    using QueueKeyValueType = typename HQueue<ValueType, uint32>::KeyValueType;
-    using QueueKeyType = typename HQueue<ValueType, uint32>::KeyType;
-    using QueueValueType = typename HQueue<ValueType, uint32>::ValueType;
     using GridIntervalType = typename KGrid<ValueType>::IntervalType;
+    using QueueKeyValueType = LinkedHierarchicalQueue::KeyValueType;
+
+    // the levels of the queue are the values shifted to start at 0.
+    auto levelOf = [minValue](ValueType v) { return static_cast<uint32>(int32(v) - minValue); };
 
     unsigned int d = 0;
     Box Fdomain = F.immerseDomain();
+    const uint32 numberOfPoints = Fdomain.numberOfPoints();
 
-    QueueType Q;
-    std::vector<ValueType> flattern = std::vector<ValueType>(Fdomain.numberOfPoints());
-    std::vector<uint32> R = std::vector<uint32>(Fdomain.numberOfPoints(), UNPROCESSED);
-    std::vector<uint32> ord = std::vector<uint32>(Fdomain.numberOfPoints(), UNPROCESSED);
-    const std::shared_ptr<Adjacency> adj = F.adj();
+    queue.reset(numberOfLevels, numberOfPoints);
+    std::vector<ValueType> &flattern = res.flattern;
+    std::vector<uint32> &R = res.R;
+    std::vector<uint32> &ord = res.orderImg;
+    flattern.resize(numberOfPoints);
+    R.assign(numberOfPoints, UNPROCESSED);
+    ord.assign(numberOfPoints, UNPROCESSED);
+    res.domain = Fdomain;
+    const AdjacencyUC &adj = *F.adj();
 
-    
-
-    ValueType lambdaOld = f[domain.pointToIndex(pInfinity)];
-    Q.insert(lambdaOld, Fdomain.pointToIndex(F.immersePoint(pInfinity)));   
+    uint32 levelOld = levelOf(f[domain.pointToIndex(pInfinity)]);
+    queue.insert(levelOld, Fdomain.pointToIndex(F.immersePoint(pInfinity)));
 
     uint32 i = R.size()-1;
 
-    while (!Q.isEmpty()) {
-      QueueKeyValueType keyvalue = Q.pop(lambdaOld);
+    while (!queue.isEmpty()) {
+      QueueKeyValueType keyvalue = queue.pop(levelOld);
       
-      QueueKeyType lambda = keyvalue.key;
-      QueueValueType pIndex = keyvalue.value;
+      uint32 level = keyvalue.key;
+      uint32 pIndex = keyvalue.value;
+      ValueType lambda = static_cast<ValueType>(int32(level) + minValue);
 
-      if (lambdaOld != keyvalue.key) {
+      if (levelOld != level) {
         d++;
       }
 
@@ -88,24 +155,22 @@ namespace morphotree {
       flattern[pIndex] = lambda;
       R[i--] = pIndex;
 
-      for (uint32 n : adj->neighbours(pIndex)) {
+      adj.forEachNeighbour(pIndex, [&](uint32 n) {
         if (ord[n] == UNPROCESSED) {
           GridIntervalType ab = F.interval(n);
           if (lambda < ab.min()) {
-            Q.insert(ab.min(), n);
+            queue.insert(levelOf(ab.min()), n);
           }
           else if (lambda > ab.max()) {
-            Q.insert(ab.max(), n);
+            queue.insert(levelOf(ab.max()), n);
           }
           else {
-            Q.insert(lambda, n);
+            queue.insert(level, n);
           }
           ord[n] = PROCESSED;
         }
-      }
-      lambdaOld = lambda;
+      });
+      levelOld = level;
     }
-
-    return OrderImageResult<ValueType>{ord, flattern, R, Fdomain};
   }  
-}
+}
\ No newline at end of file
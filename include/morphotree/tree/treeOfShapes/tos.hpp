@@ -62,16 +62,27 @@ namespace morphotree
     const KGrid<WeightType> &grid,
     const MorphologicalTree<WeightType> &treeOfShapes);
 
+  // emerges "treeOfShapes" into the given arrays (reusing their storage),
+  // which make the emerged tree, e.g. through MorphologicalTree::swapAssign.
+  template<class WeightType>
+  void emergeTreeOfShapes(
+    const KGrid<WeightType> &grid,
+    const MorphologicalTree<WeightType> &treeOfShapes,
+    std::vector<uint32> &cmap, std::vector<uint32> &parent,
+    std::vector<WeightType> &level, std::vector<uint32> &representative);
+
   // ========================= [ Implementation ] ===============================================
+  // The parent array is built into a local buffer and the trees read the
+  // order image and R in place, so none of the arrays of the order image
+  // is copied.
+
   // Build max-tree of the order image
   template<class WeightType>
   MorphologicalTree<uint32> buildOrderImageMaxtree(const Box &domain, 
     const std::vector<WeightType> &f, const KGrid<WeightType> &kgrid, I32Point pInfty)
   {
     OrderImageResult<WeightType> orderRes = computeOrderImage(domain, f, kgrid, pInfty);
-    CTBuilder<uint32> builder;
-    return MorphologicalTree<uint32>{MorphoTreeType::MaxTree, 
-      orderRes.orderImg, builder.build(orderRes.orderImg, kgrid.adj(), orderRes.R)};
+    return buildOrderImageMaxtree(orderRes, kgrid, pInfty);
   }
 
   template<class WeightType>
@@ -87,13 +98,10 @@ namespace morphotree
     const OrderImageResult<WeightType> &orderRes, const KGrid<WeightType> &kgrid,
     I32Point pInfty)
   {
-    const std::vector<uint32>& orderImage = orderRes.orderImg;
-    const std::vector<uint32>& R = orderRes.R;
-    const std::vector<WeightType> &flattern = orderRes.flattern; 
-
-    CTBuilder<uint32> builder;
-    return MorphologicalTree<uint32>(MorphoTreeType::MaxTree, 
-      orderImage, builder.build(orderImage, kgrid.adj(), R));
+    std::vector<uint32> parent;
+    CTBuilder<uint32>().build(orderRes.orderImg, *kgrid.adj(), orderRes.R, parent);
+    return MorphologicalTree<uint32>(MorphoTreeType::MaxTree, orderRes.orderImg, parent,
+      orderRes.R);
   }
 
 
@@ -104,9 +112,7 @@ namespace morphotree
     I32Point pInfty)
   { 
     OrderImageResult<WeightType> orderRes = computeOrderImage(domain, f, kgrid, pInfty);
-    CTBuilder<uint32> builder;
-    return MorphologicalTree<WeightType>{MorphoTreeType::TreeOfShapes,
-      orderRes.flattern, builder.build(orderRes.orderImg, kgrid.adj(), orderRes.R)};
+    return buildEnlargedTreeOfShapes(orderRes, kgrid, pInfty);
   }
 
   template<class WeightType>
@@ -122,13 +128,10 @@ namespace morphotree
     const OrderImageResult<WeightType> &orderRes, const KGrid<WeightType> &kgrid,
     I32Point pInfty)
   {
-    const std::vector<uint32>& orderImage = orderRes.orderImg;
-    const std::vector<uint32>& R = orderRes.R;
-    const std::vector<WeightType> &flattern = orderRes.flattern; 
-
-    CTBuilder<uint32> builder;
-    return MorphologicalTree<WeightType>{MorphoTreeType::TreeOfShapes,
-      flattern, builder.build(orderImage, kgrid.adj(), R)};
+    std::vector<uint32> parent;
+    CTBuilder<uint32>().build(orderRes.orderImg, *kgrid.adj(), orderRes.R, parent);
+    return MorphologicalTree<WeightType>(MorphoTreeType::TreeOfShapes, orderRes.flattern,
+      parent, orderRes.R);
   }
   
   // build tree of shapes by emerging all nodes.  
@@ -138,9 +141,7 @@ namespace morphotree
     I32Point pInfty)
   {
     OrderImageResult<WeightType> orderRes = computeOrderImage(domain, f, kgrid, pInfty);
-    CTBuilder<uint32> builder;
-    return emergeTreeOfShapes(kgrid, MorphologicalTree<WeightType>{MorphoTreeType::TreeOfShapes,
-      orderRes.flattern, builder.build(orderRes.orderImg, kgrid.adj(), orderRes.R)}); 
+    return buildTreeOfShapes(orderRes, kgrid, pInfty);
   }
 
   template<class WeightType>
@@ -156,13 +157,7 @@ namespace morphotree
     const OrderImageResult<WeightType> &orderRes, const KGrid<WeightType> &kgrid,
     I32Point pInfty)
   {
-    const std::vector<uint32>& orderImage = orderRes.orderImg;
-    const std::vector<uint32>& R = orderRes.R;
-    const std::vector<WeightType> &flattern = orderRes.flattern; 
-
-    CTBuilder<uint32> builder;
-    return emergeTreeOfShapes(kgrid, MorphologicalTree<WeightType>{ MorphoTreeType::TreeOfShapes,
-      flattern, builder.build(orderImage, kgrid.adj(), R)});
+    return emergeTreeOfShapes(kgrid, buildEnlargedTreeOfShapes(orderRes, kgrid, pInfty));
   }
 
   template<class WeightType> 
@@ -170,36 +165,41 @@ namespace morphotree
     const KGrid<WeightType> &grid,
     const MorphologicalTree<WeightType> &treeOfShapes)
   {
-    using MTree = MorphologicalTree<WeightType>;
-    using NodePtr = typename MorphologicalTree<WeightType>::NodePtr; 
-    using NodeType = typename MorphologicalTree<WeightType>::NodeType; 
-
-    std::vector<NodePtr> nodes = std::vector<NodePtr>(treeOfShapes.numberOfNodes());
-    std::vector<uint32> cmap  = std::vector<uint32>(grid.emergeDomain().numberOfPoints());
-
-    treeOfShapes.traverseByLevel([&nodes, &grid, &cmap](const NodePtr oldNode) {
-      NodePtr newNode =   std::make_shared<NodeType>(oldNode->id());
-      newNode->level(oldNode->level());
-      newNode->includeCNPS(grid.emergeSet(oldNode->cnps()));
-      nodes[oldNode->id()] = newNode;
-
-      for (uint32 cnp : newNode->cnps()) {
-        cmap[cnp] = newNode->id();
-      }      
-    });
-
-
-    treeOfShapes.traverseByLevel([&nodes](const NodePtr oldNode){
-      NodePtr newNode = nodes[oldNode->id()];
-      if (oldNode->parent() != nullptr) {
-        newNode->parent(nodes[oldNode->parent()->id()]);
-      }
+    std::vector<uint32> cmap;
+    std::vector<uint32> parent;
+    std::vector<WeightType> level;
+    std::vector<uint32> representative;
+    emergeTreeOfShapes(grid, treeOfShapes, cmap, parent, level, representative);
+    return MorphologicalTree<WeightType>{treeOfShapes.type(), std::move(cmap), std::move(parent),
+      std::move(level), std::move(representative)};
+  }
 
-      for (NodePtr child : oldNode->children()) {
-        newNode->appendChild(nodes[child->id()]);
-      }
-    }); 
+  template<class WeightType>
+  void emergeTreeOfShapes(
+    const KGrid<WeightType> &grid,
+    const MorphologicalTree<WeightType> &treeOfShapes,
+    std::vector<uint32> &cmap, std::vector<uint32> &parent,
+    std::vector<WeightType> &level, std::vector<uint32> &representative)
+  {
+    using MTree = MorphologicalTree<WeightType>;
 
-    return MTree{treeOfShapes.type(), std::move(cmap), std::move(nodes)};
+    const Box domain = grid.emergeDomain();
+    const std::vector<uint32> &tcmap = treeOfShapes.cmap();
+    parent.assign(treeOfShapes.parents().begin(), treeOfShapes.parents().end());
+    level.assign(treeOfShapes.levels().begin(), treeOfShapes.levels().end());
+    representative.assign(treeOfShapes.numberOfNodes(), MTree::UndefinedIndex);
+    cmap.resize(domain.numberOfPoints());
+
+    for (uint32 p = 0; p < cmap.size(); p++) {
+      cmap[p] = tcmap[grid.immersePoint(p)];
+      if (representative[cmap[p]] == MTree::UndefinedIndex)
+        representative[cmap[p]] = p;
+    }
+
+    // nodes without any emerged pixel keep a point close to their original representative.
+    for (uint32 id = 0; id < representative.size(); id++) {
+      if (representative[id] == MTree::UndefinedIndex)
+        representative[id] = grid.emergePoint(treeOfShapes.representative(id));
+    }
   }
 }
\ No newline at end of file
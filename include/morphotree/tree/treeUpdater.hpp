@@ -0,0 +1,967 @@
+#pragma once
+
+#include "morphotree/core/alias.hpp"
+#include "morphotree/core/box.hpp"
+#include "morphotree/adjacency/adjacency.hpp"
+#include "morphotree/adjacency/adjacencyDispatch.hpp"
+#include "morphotree/tree/mtree.hpp"
+#include "morphotree/tree/levelRootMerge.hpp"
+
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <limits>
+#include <memory>
+
+namespace morphotree
+{
+  // TreeUpdater updates a max-tree or min-tree in place after the pixels of
+  // a box "region" of the image take new values, e.g. after an edit in an
+  // annotation tool, instead of building the tree of the whole image again.
+  // Let m be the shallowest of the old and new values of the region: the
+  // level sets at the levels shallower than m do not change, and neither do
+  // their nodes. The branches touched by the edit, i.e., the nodes with CNPs
+  // in the region and their ancestors down to level m, are torn down and
+  // their CNPs become free pixels. The subtrees hanging from them keep their
+  // nodes; a region pixel whose new value is deeper than the root of a
+  // neighbouring subtree also tears down the part of the subtree it rises
+  // above. An unchanged pixel only meets subtrees deeper than itself, so
+  // each subtree is merged as a single element at the level of its root:
+  // the free pixels and the roots of the subtrees are merged by the
+  // union-find of CTBuilder, from the deepest to the shallowest, and the
+  // merged nodes hang from the kept node the torn ones hung from (the
+  // anchor).
+  // The node ids are assigned locally, from the deepest merged node to the
+  // shallowest, keeping the tree top-down (a parent has a smaller id than
+  // its children): a merged node keeps the smallest id of the subtree roots
+  // it contains when it is smaller than the ids of its children; otherwise
+  // it takes the greatest free id (of a torn node or of a merged subtree
+  // root) smaller than the ids of its children, or the id of an untouched
+  // leaf in that range, which moves to a new id at the end. When there is
+  // no such id, the node takes a new id and the chain of its smallest
+  // descendants is pushed down one step. The ids left unused are filled by
+  // moving the last nodes. Hence, only the entries of the torn, merged and
+  // moved nodes and the node map of their pixels are written, and the
+  // packed children and CNPs are patched for the changed nodes only. The
+  // result is the tree which buildMaxTree (buildMinTree) builds from the
+  // edited image, but with other node ids. A depth-first numbered tree is
+  // numbered depth-first again, which renumbers the whole tree. The
+  // buffers are kept by the updater for the next edits.
+  template<class WeightType>
+  class TreeUpdater
+  {
+  public:
+    TreeUpdater(const Box &domain);
+
+    inline const Box& domain() const { return domain_; }
+
+    // "values" are the new values of the pixels of "region", a box inside
+    // the domain, in raster order.
+    void update(MorphologicalTree<WeightType> &tree, std::shared_ptr<Adjacency> adj,
+      const Box &region, const std::vector<WeightType> &values);
+
+    template<class AdjacencyType, class = RequireAdjacency<AdjacencyType>>
+    void update(MorphologicalTree<WeightType> &tree, const AdjacencyType &adj,
+      const Box &region, const std::vector<WeightType> &values);
+
+  private:
+    static const uint32 UNDEF;
+
+    void checkArguments(const MorphologicalTree<WeightType> &tree, const Box &region,
+      const std::vector<WeightType> &values) const;
+
+    // marks the torn nodes and collects their CNPs into "free_", with the
+    // new values of the region.
+    template<class AdjacencyType>
+    void tearDown(const MorphologicalTree<WeightType> &tree, const AdjacencyType &adj,
+      const Box &region, const std::vector<WeightType> &values);
+
+    void tearAncestors(const MorphologicalTree<WeightType> &tree, uint32 id);
+
+    // levels of the free pixels and of the anchor.
+    void initElements(const MorphologicalTree<WeightType> &tree);
+
+    template<class AdjacencyType>
+    void merge(const MorphologicalTree<WeightType> &tree, const AdjacencyType &adj);
+
+    // root of the kept subtree of the (kept) node "id" under the torn
+    // nodes or the nodes shallower than m.
+    uint32 subtreeRoot(const MorphologicalTree<WeightType> &tree, uint32 id);
+
+    // ids of the merged nodes (the level roots of the merged elements),
+    // from the deepest to the shallowest.
+    void assignIds(const MorphologicalTree<WeightType> &tree);
+
+    // largest free id smaller than "hi", which may be taken from an
+    // untouched leaf moved to a new id, or UNDEF.
+    uint32 takeId(const MorphologicalTree<WeightType> &tree, uint32 hi);
+
+    void addNode(uint32 id, uint32 parent, WeightType level, uint32 representative,
+      uint32 source);
+
+    void writeNodes(MorphologicalTree<WeightType> &tree);
+
+    // write the parent of node "id" and the node of pixel "p", and record
+    // the nodes whose children or CNPs change.
+    void setParent(MorphologicalTree<WeightType> &tree, uint32 id, uint32 parent);
+    void setNode(MorphologicalTree<WeightType> &tree, uint32 p, uint32 id);
+    void markChanged(std::vector<bool> &changed, std::vector<uint32> &ids, uint32 id);
+
+    // rewrites the packed children and CNPs of the changed nodes.
+    void patchTree(MorphologicalTree<WeightType> &tree);
+
+    // "owner" gives the node an item of "data" belongs to now.
+    template<class OwnerFunc>
+    void patchPacked(std::vector<uint32> &offset, std::vector<uint32> &data,
+      uint32 numberOfNodes, std::vector<bool> &changed, std::vector<uint32> &changedIds,
+      std::vector<uint32> &moved, OwnerFunc owner);
+
+    // numbers the merged nodes which took ids greater than the ids of
+    // their children again, with the chains of their smallest descendants.
+    void pushDown(MorphologicalTree<WeightType> &tree);
+
+    // moves the last nodes into the unused ids "holes_", then drops the
+    // ids past the last node.
+    void fillHoles(MorphologicalTree<WeightType> &tree);
+
+    // sets the per-node flags touched by the update back to their default.
+    void reset();
+
+    inline bool isDeeper(WeightType a, WeightType b) const { return maxTree_ ? a > b : a < b; }
+    uint32 findRoot(uint32 x);
+
+  private:
+    Box domain_;
+    bool maxTree_;
+    WeightType m_;
+    uint32 numberOfNodes_;
+    uint32 anchor_;
+    uint32 nextId_;
+
+    // the elements are the nodes of the tree, [0, numberOfNodes_), followed
+    // by the free pixels, in the order of "free_". "torn_", "subtreeRoot_"
+    // and "inOrder_" are indexed by node and only the entries touched by an
+    // update are reset, so they are not filled again for every update.
+    std::vector<bool> torn_;
+    std::vector<uint32> tornNodes_;
+    std::vector<uint32> free_;
+    std::vector<uint32> freeIndex_;
+    std::vector<WeightType> freeLevel_;
+    std::vector<uint32> parent_;
+    std::vector<WeightType> level_;
+
+    std::vector<uint32> subtreeRoot_;
+    std::vector<uint32> visited_;
+    std::vector<bool> inOrder_;
+    std::vector<uint32> order_;
+    std::vector<uint32> zpar_;
+    std::vector<uint8> rank_;
+    std::vector<uint32> repr_;
+
+    // level root of every merged element, and smallest merged subtree root
+    // and smallest child of every merged node: the node keeps the id of
+    // that root if it is smaller than the ids of its children.
+    std::vector<uint32> root_;
+    std::vector<uint32> minRoot_;
+    std::vector<uint32> minChild_;
+    std::vector<uint32> newId_;
+    std::vector<bool> evicted_;
+    std::vector<uint32> evictedNodes_;
+    std::vector<uint32> pushedDown_;
+
+    // free ids: those of the torn nodes and of the merged subtree roots
+    // whose id is not kept.
+    std::set<uint32> pool_;
+    std::vector<uint32> holes_;
+
+    // nodes whose children or CNPs changed, and the nodes and pixels
+    // written since the last patch of the packed arrays.
+    std::vector<bool> childrenChanged_;
+    std::vector<bool> cnpsChanged_;
+    std::vector<uint32> changedParents_;
+    std::vector<uint32> changedNodes_;
+    std::vector<uint32> reparented_;
+    std::vector<uint32> remapped_;
+    std::vector<uint64> movedKeys_;
+    std::vector<uint32> offsetBuffer_;
+    std::vector<uint32> dataBuffer_;
+
+    // ids of the nodes moved by pushDown(), and the moved children of
+    // every node as linked lists.
+    std::vector<bool> moved_;
+    std::vector<uint32> slot_;
+    std::vector<uint32> movedHead_;
+    std::vector<uint32> movedNext_;
+    std::vector<uint32> movedNodes_;
+    std::vector<uint32> chain_;
+    std::vector<uint32> chainId_;
+
+    // entries of the nodes to write, and the old id of the moved ones.
+    std::vector<uint32> nodeId_;
+    std::vector<uint32> nodeParent_;
+    std::vector<WeightType> nodeLevel_;
+    std::vector<uint32> nodeRepresentative_;
+    std::vector<uint32> nodeSource_;
+
+    // id, before any hole is filled, of the node moved into an id, and the
+    // other way round.
+    std::unordered_map<uint32, uint32> origin_;
+    std::unordered_map<uint32, uint32> forward_;
+  };
+
+  // updates "tree", a tree of an image of "domain", with a temporary
+  // TreeUpdater.
+  template<class WeightType>
+  void updateTree(MorphologicalTree<WeightType> &tree, const Box &domain,
+    std::shared_ptr<Adjacency> adj, const Box &region, const std::vector<WeightType> &values);
+
+  // ===================== [ IMPLEMENTATION ] ==================================
+  template<class WeightType>
+  const uint32 TreeUpdater<WeightType>::UNDEF = std::numeric_limits<uint32>::max();
+
+  template<class WeightType>
+  TreeUpdater<WeightType>::TreeUpdater(const Box &domain)
+    :domain_{domain}, maxTree_{true}, m_{}, numberOfNodes_{0}, anchor_{UNDEF}, nextId_{0},
+     freeIndex_(domain.numberOfPoints())
+  {}
+
+  template<class WeightType>
+  void TreeUpdater<WeightType>::update(MorphologicalTree<WeightType> &tree,
+    std::shared_ptr<Adjacency> adj, const Box &region, const std::vector<WeightType> &values)
+  {
+    withStaticAdjacency(*adj, [&](const auto &a) { update(tree, a, region, values); });
+  }
+
+  template<class WeightType>
+  template<class AdjacencyType, class>
+  void TreeUpdater<WeightType>::update(MorphologicalTree<WeightType> &tree,
+    const AdjacencyType &adj, const Box &region, const std::vector<WeightType> &values)
+  {
+    checkArguments(tree, region, values);
+    maxTree_ = tree.type() == MorphoTreeType::MaxTree;
+    numberOfNodes_ = tree.numberOfNodes();
+
+    tearDown(tree, adj, region, values);
+    initElements(tree);
+    merge(tree, adj);
+    assignIds(tree);
+    writeNodes(tree);
+    reset();
+  }
+
+  template<class WeightType>
+  void TreeUpdater<WeightType>::checkArguments(const MorphologicalTree<WeightType> &tree,
+    const Box &region, const std::vector<WeightType> &values) const
+  {
+    if (tree.type() == MorphoTreeType::TreeOfShapes)
+      throw std::runtime_error("TreeUpdater: only max-trees and min-trees can be updated.");
+    if (tree.numberOfCNPs() != domain_.numberOfPoints())
+      throw std::runtime_error("TreeUpdater: the tree does not match the domain of the updater.");
+    if (!domain_.contains(region.topleft()) || !domain_.contains(region.bottomright()))
+      throw std::runtime_error("TreeUpdater: the region is not inside the domain.");
+    if (values.size() != region.numberOfPoints())
+      throw std::runtime_error("TreeUpdater: the number of values does not match the region.");
+  }
+
+  template<class WeightType>
+  template<class AdjacencyType>
+  void TreeUpdater<WeightType>::tearDown(const MorphologicalTree<WeightType> &tree,
+    const AdjacencyType &adj, const Box &region, const std::vector<WeightType> &values)
+  {
+    using MTree = MorphologicalTree<WeightType>;
+    const std::vector<uint32> &cmap = tree.cmap();
+
+    m_ = values[0];
+    uint32 k = 0;
+    for (int32 y = region.top(); y <= region.bottom(); y++) {
+      for (int32 x = region.left(); x <= region.right(); x++, k++) {
+        WeightType old = tree.level(cmap[domain_.pointToIndex(x, y)]);
+        if (isDeeper(m_, old))
+          m_ = old;
+        if (isDeeper(m_, values[k]))
+          m_ = values[k];
+      }
+    }
+
+    // the nodes of the region pixels are never shallower than m, so the
+    // region pixels are all free.
+    torn_.resize(numberOfNodes_, false);
+    tornNodes_.clear();
+    free_.clear();
+    freeLevel_.clear();
+    for (int32 y = region.top(); y <= region.bottom(); y++) {
+      for (int32 x = region.left(); x <= region.right(); x++)
+        tearAncestors(tree, cmap[domain_.pointToIndex(x, y)]);
+    }
+
+    // a region pixel joins the nodes of a neighbouring kept subtree which
+    // are not deeper than its new value.
+    k = 0;
+    for (int32 y = region.top(); y <= region.bottom(); y++) {
+      for (int32 x = region.left(); x <= region.right(); x++, k++) {
+        adj.forEachNeighbour(domain_.pointToIndex(x, y), [&](uint32 n) {
+          uint32 id = cmap[n];
+          if (torn_[id] || isDeeper(m_, tree.level(id)))
+            return;
+          while (!torn_[id] && isDeeper(tree.level(id), values[k]))
+            id = tree.parent(id);
+          tearAncestors(tree, id);
+        });
+      }
+    }
+
+    k = 0;
+    for (int32 y = region.top(); y <= region.bottom(); y++) {
+      for (int32 x = region.left(); x <= region.right(); x++, k++)
+        freeLevel_[freeIndex_[domain_.pointToIndex(x, y)]] = values[k];
+    }
+
+    // the torn nodes are the nodes of the component of the region at level
+    // m, so they all descend from the one with the smallest id, and the
+    // anchor is its parent.
+    uint32 top = *std::min_element(tornNodes_.begin(), tornNodes_.end());
+    anchor_ = tree.parent(top) == MTree::UndefinedIndex ? UNDEF : tree.parent(top);
+  }
+
+  template<class WeightType>
+  void TreeUpdater<WeightType>::tearAncestors(const MorphologicalTree<WeightType> &tree,
+    uint32 id)
+  {
+    using MTree = MorphologicalTree<WeightType>;
+    while (id != MTree::UndefinedIndex && !torn_[id] && !isDeeper(m_, tree.level(id))) {
+      torn_[id] = true;
+      tornNodes_.push_back(id);
+      for (uint32 p : tree.cnps(id)) {
+        freeIndex_[p] = free_.size();
+        free_.push_back(p);
+        freeLevel_.push_back(tree.level(id));
+      }
+      id = tree.parent(id);
+    }
+  }
+
+  template<class WeightType>
+  void TreeUpdater<WeightType>::initElements(const MorphologicalTree<WeightType> &tree)
+  {
+    // the levels of the subtree roots are set by merge(), when they are
+    // met.
+    const uint32 numberOfElements = numberOfNodes_ + free_.size();
+    parent_.resize(numberOfElements);
+    level_.resize(numberOfElements);
+    for (uint32 i = 0; i < free_.size(); i++)
+      level_[numberOfNodes_ + i] = freeLevel_[i];
+    if (anchor_ != UNDEF)
+      level_[anchor_] = tree.level(anchor_);
+  }
+
+  template<class WeightType>
+  template<class AdjacencyType>
+  void TreeUpdater<WeightType>::merge(const MorphologicalTree<WeightType> &tree,
+    const AdjacencyType &adj)
+  {
+    // the elements to merge are the free pixels and the roots of the kept
+    // subtrees they meet. The neighbours shallower than m are skipped: the
+    // connections through them are kept by the nodes shallower than m.
+    // Every child of a torn node meets a CNP of its parent, so it is met.
+    const std::vector<uint32> &cmap = tree.cmap();
+    subtreeRoot_.resize(numberOfNodes_, UNDEF);
+    inOrder_.resize(numberOfNodes_, false);
+    visited_.clear();
+    order_.clear();
+    for (uint32 i = 0; i < free_.size(); i++) {
+      order_.push_back(numberOfNodes_ + i);
+      adj.forEachNeighbour(free_[i], [&](uint32 n) {
+        uint32 id = cmap[n];
+        if (torn_[id] || isDeeper(m_, tree.level(id)))
+          return;
+        uint32 r = subtreeRoot(tree, id);
+        if (!inOrder_[r]) {
+          inOrder_[r] = true;
+          level_[r] = tree.level(r);
+          order_.push_back(r);
+        }
+      });
+    }
+
+    std::sort(order_.begin(), order_.end(), [this](uint32 a, uint32 b) {
+      return isDeeper(level_[a], level_[b]);
+    });
+
+    // union-find of CTBuilder::build: "repr_" is the node root of a set,
+    // which is the element being processed for its own set. The roots of the kept
+    // subtrees are deeper than the free pixels they meet, so their edges
+    // are all merged from the free pixels.
+    const uint32 numberOfElements = numberOfNodes_ + free_.size();
+    zpar_.resize(numberOfElements);
+    rank_.resize(numberOfElements);
+    repr_.resize(numberOfElements);
+    for (uint32 e : order_)
+      zpar_[e] = UNDEF;
+
+    for (uint32 e : order_) {
+      parent_[e] = e;
+      zpar_[e] = e;
+      rank_[e] = 0;
+      repr_[e] = e;
+      if (e < numberOfNodes_)
+        continue;
+
+      adj.forEachNeighbour(free_[e - numberOfNodes_], [&](uint32 n) {
+        uint32 id = cmap[n], w;
+        if (torn_[id])
+          w = numberOfNodes_ + freeIndex_[n];
+        else if (isDeeper(m_, tree.level(id)))
+          return;
+        else
+          w = subtreeRoot_[id];
+        if (zpar_[w] == UNDEF)
+          return;
+
+        uint32 ze = findRoot(e), zw = findRoot(w);
+        if (ze == zw)
+          return;
+        parent_[repr_[zw]] = e;
+        if (rank_[ze] < rank_[zw])
+          std::swap(ze, zw);
+        zpar_[zw] = ze;
+        if (rank_[ze] == rank_[zw])
+          rank_[ze]++;
+        repr_[ze] = e;
+      });
+    }
+
+    // the level set at m of the region is unchanged, so the merged elements
+    // are connected and go under the anchor.
+    if (anchor_ != UNDEF) {
+      for (uint32 e : order_) {
+        if (parent_[e] == e)
+          parent_[e] = anchor_;
+      }
+    }
+  }
+
+  template<class WeightType>
+  uint32 TreeUpdater<WeightType>::subtreeRoot(const MorphologicalTree<WeightType> &tree,
+    uint32 id)
+  {
+    uint32 x = id;
+    while (subtreeRoot_[x] == UNDEF) {
+      uint32 par = tree.parent(x);
+      if (torn_[par] || isDeeper(m_, tree.level(par))) {
+        subtreeRoot_[x] = x;
+        visited_.push_back(x);
+        break;
+      }
+      x = par;
+    }
+
+    const uint32 r = subtreeRoot_[x];
+    for (uint32 y = id; y != x; y = tree.parent(y)) {
+      subtreeRoot_[y] = r;
+      visited_.push_back(y);
+    }
+    return r;
+  }
+
+  template<class WeightType>
+  void TreeUpdater<WeightType>::assignIds(const MorphologicalTree<WeightType> &tree)
+  {
+    using MTree = MorphologicalTree<WeightType>;
+    const uint32 numberOfElements = numberOfNodes_ + free_.size();
+    root_.resize(numberOfElements);
+    minRoot_.resize(numberOfElements);
+    minChild_.resize(numberOfElements);
+    newId_.resize(numberOfElements);
+    evicted_.resize(numberOfNodes_, false);
+
+    LevelRootMerge<WeightType> merge{parent_, level_, maxTree_};
+    for (uint32 e : order_) {
+      root_[e] = merge.levelRoot(e);
+      minRoot_[root_[e]] = UNDEF;
+      minChild_[root_[e]] = UNDEF;
+    }
+
+    for (uint32 e : order_) {
+      if (e >= numberOfNodes_)
+        continue;
+      uint32 r = root_[e];
+      minRoot_[r] = std::min(minRoot_[r], e);
+      for (uint32 c : tree.children(e))
+        minChild_[r] = std::min(minChild_[r], c);
+    }
+
+    // id 0 is left to the new root, when the root is torn.
+    pool_.clear();
+    for (uint32 id : tornNodes_) {
+      if (id != 0)
+        pool_.insert(id);
+    }
+    for (uint32 e : order_) {
+      uint32 r = root_[e];
+      if (e < numberOfNodes_ && (e != minRoot_[r] || parent_[r] == r))
+        pool_.insert(e);
+    }
+
+    // from the deepest node to the shallowest, so that the ids of the
+    // children of a node are known: "minChild_" becomes the smallest id of
+    // the children.
+    evictedNodes_.clear();
+    pushedDown_.clear();
+    nextId_ = numberOfNodes_;
+    for (uint32 r : order_) {
+      if (root_[r] != r)
+        continue;
+
+      // a node pushed down takes the smallest id of its subtree.
+      uint32 par = parent_[r], k = minRoot_[r], id, low = UNDEF;
+      if (par == r) {
+        id = 0;
+      }
+      else if (k < minChild_[r]) {
+        id = k;
+      }
+      else {
+        if (k != UNDEF)
+          pool_.insert(k);
+        id = takeId(tree, minChild_[r]);
+        if (id == UNDEF) {
+          id = nextId_++;
+          low = minChild_[r];
+          pushedDown_.push_back(r);
+        }
+      }
+
+      newId_[r] = id;
+      if (par != r && par != anchor_)
+        minChild_[root_[par]] = std::min(minChild_[root_[par]], std::min(id, low));
+    }
+
+    holes_.assign(pool_.begin(), pool_.end());
+
+    // the entries of the nodes are read before any of them is written.
+    nodeId_.clear();
+    nodeParent_.clear();
+    nodeLevel_.clear();
+    nodeRepresentative_.clear();
+    nodeSource_.clear();
+    for (uint32 r : order_) {
+      if (root_[r] != r)
+        continue;
+      uint32 par = parent_[r], parentId;
+      if (par == r)
+        parentId = MTree::UndefinedIndex;
+      else
+        parentId = par == anchor_ ? anchor_ : newId_[root_[par]];
+      uint32 rep = minRoot_[r] != UNDEF ? tree.representative(minRoot_[r])
+        : free_[r - numberOfNodes_];
+      addNode(newId_[r], parentId, level_[r], rep, UNDEF);
+    }
+
+    for (uint32 x : evictedNodes_) {
+      uint32 par = tree.parent(x);
+      addNode(newId_[x], inOrder_[par] ? newId_[root_[par]] : par, tree.level(x),
+        tree.representative(x), x);
+    }
+  }
+
+  template<class WeightType>
+  uint32 TreeUpdater<WeightType>::takeId(const MorphologicalTree<WeightType> &tree, uint32 hi)
+  {
+    auto it = pool_.lower_bound(hi);
+    if (it != pool_.begin()) {
+      uint32 id = *--it;
+      pool_.erase(it);
+      return id;
+    }
+    if (hi == UNDEF)
+      return nextId_++;
+
+    // the id of a leaf which is neither torn nor merged, between the
+    // anchor and "hi": the leaf moves to a new id.
+    const uint32 lo = anchor_ == UNDEF ? 0 : anchor_;
+    for (uint32 x = std::min(hi, numberOfNodes_) - 1; x > lo; x--) {
+      if (!torn_[x] && !inOrder_[x] && !evicted_[x] && tree.numberOfChildren(x) == 0) {
+        evicted_[x] = true;
+        evictedNodes_.push_back(x);
+        newId_[x] = nextId_++;
+        return x;
+      }
+    }
+    return UNDEF;
+  }
+
+  template<class WeightType>
+  void TreeUpdater<WeightType>::addNode(uint32 id, uint32 parent, WeightType level,
+    uint32 representative, uint32 source)
+  {
+    nodeId_.push_back(id);
+    nodeParent_.push_back(parent);
+    nodeLevel_.push_back(level);
+    nodeRepresentative_.push_back(representative);
+    nodeSource_.push_back(source);
+  }
+
+  template<class WeightType>
+  void TreeUpdater<WeightType>::writeNodes(MorphologicalTree<WeightType> &tree)
+  {
+    using MTree = MorphologicalTree<WeightType>;
+
+    // the packed children and CNPs of the tree are read before they are
+    // patched: they are still the ones of the old nodes.
+    tree.parent_.resize(nextId_, MTree::UndefinedIndex);
+    tree.level_.resize(nextId_);
+    tree.representative_.resize(nextId_);
+    childrenChanged_.resize(nextId_, false);
+    cnpsChanged_.resize(nextId_, false);
+    for (uint32 i = 0; i < nodeId_.size(); i++) {
+      uint32 id = nodeId_[i];
+      setParent(tree, id, nodeParent_[i]);
+      tree.level_[id] = nodeLevel_[i];
+      tree.representative_[id] = nodeRepresentative_[i];
+      if (nodeSource_[i] != UNDEF) {
+        for (uint32 p : tree.cnps(nodeSource_[i]))
+          setNode(tree, p, id);
+      }
+    }
+
+    for (uint32 e : order_) {
+      uint32 id = newId_[root_[e]];
+      if (e >= numberOfNodes_) {
+        setNode(tree, free_[e - numberOfNodes_], id);
+        continue;
+      }
+      if (e == id)
+        continue;
+      for (uint32 p : tree.cnps(e))
+        setNode(tree, p, id);
+      for (uint32 c : tree.children(e)) {
+        if (!evicted_[c])
+          setParent(tree, c, id);
+      }
+    }
+
+    for (uint32 h : holes_)
+      setParent(tree, h, MTree::UndefinedIndex);
+
+    const bool depthFirst = tree.isDepthFirst();
+    tree.depthFirst_ = false;
+    tree.depth_.clear();
+    tree.subtreeSize_.clear();
+    tree.leaves_.clear();
+    patchTree(tree);
+    if (!pushedDown_.empty()) {
+      pushDown(tree);
+      patchTree(tree);
+    }
+    if (!holes_.empty()) {
+      fillHoles(tree);
+      patchTree(tree);
+    }
+    if (depthFirst)
+      tree.renumberDepthFirst();
+  }
+
+  template<class WeightType>
+  void TreeUpdater<WeightType>::setParent(MorphologicalTree<WeightType> &tree, uint32 id,
+    uint32 parent)
+  {
+    markChanged(childrenChanged_, changedParents_, tree.parent_[id]);
+    markChanged(childrenChanged_, changedParents_, parent);
+    tree.parent_[id] = parent;
+    reparented_.push_back(id);
+  }
+
+  template<class WeightType>
+  void TreeUpdater<WeightType>::setNode(MorphologicalTree<WeightType> &tree, uint32 p, uint32 id)
+  {
+    markChanged(cnpsChanged_, changedNodes_, tree.cmap_[p]);
+    markChanged(cnpsChanged_, changedNodes_, id);
+    tree.cmap_[p] = id;
+    remapped_.push_back(p);
+  }
+
+  template<class WeightType>
+  void TreeUpdater<WeightType>::markChanged(std::vector<bool> &changed,
+    std::vector<uint32> &ids, uint32 id)
+  {
+    if (id != UNDEF && !changed[id]) {
+      changed[id] = true;
+      ids.push_back(id);
+    }
+  }
+
+  template<class WeightType>
+  void TreeUpdater<WeightType>::patchTree(MorphologicalTree<WeightType> &tree)
+  {
+    using MTree = MorphologicalTree<WeightType>;
+    const uint32 numberOfNodes = tree.parent_.size();
+    const std::vector<uint32> &parent = tree.parent_, &cmap = tree.cmap_;
+
+    // the nodes past the last id are dropped.
+    reparented_.erase(std::remove_if(reparented_.begin(), reparented_.end(),
+      [numberOfNodes, &parent](uint32 c) {
+        return c >= numberOfNodes || parent[c] == MTree::UndefinedIndex;
+      }), reparented_.end());
+    patchPacked(tree.childOffset_, tree.children_, numberOfNodes, childrenChanged_,
+      changedParents_, reparented_, [numberOfNodes, &parent](uint32 c) {
+        return c < numberOfNodes ? parent[c] : UNDEF;
+      });
+    patchPacked(tree.cnpOffset_, tree.cnps_, numberOfNodes, cnpsChanged_, changedNodes_,
+      remapped_, [&cmap](uint32 p) { return cmap[p]; });
+
+    while (tree.nodes_.size() > numberOfNodes)
+      tree.nodes_.pop_back();
+    while (tree.nodes_.size() < numberOfNodes)
+      tree.nodes_.emplace_back(&tree, tree.nodes_.size());
+  }
+
+  template<class WeightType>
+  template<class OwnerFunc>
+  void TreeUpdater<WeightType>::patchPacked(std::vector<uint32> &offset,
+    std::vector<uint32> &data, uint32 numberOfNodes, std::vector<bool> &changed,
+    std::vector<uint32> &changedIds, std::vector<uint32> &moved, OwnerFunc owner)
+  {
+    // the list of a changed node is its old list without the items which
+    // left it, merged with the moved items it owns now. The lists of the
+    // other nodes are copied by blocks, and the lists before the first
+    // changed node stay where they are.
+    std::sort(changedIds.begin(), changedIds.end());
+    movedKeys_.clear();
+    for (uint32 x : moved)
+      movedKeys_.push_back(uint64(owner(x)) << 32 | x);
+    std::sort(movedKeys_.begin(), movedKeys_.end());
+    movedKeys_.erase(std::unique(movedKeys_.begin(), movedKeys_.end()), movedKeys_.end());
+    auto movedOwner = [this](uint32 m) { return uint32(movedKeys_[m] >> 32); };
+    auto movedItem = [this](uint32 m) { return uint32(movedKeys_[m]); };
+
+    const uint32 oldNumberOfNodes = offset.size() - 1;
+    uint32 lo = std::min(numberOfNodes, oldNumberOfNodes);
+    if (!changedIds.empty())
+      lo = std::min(lo, changedIds.front());
+
+    const uint32 base = offset[lo];
+    auto oldBegin = [&offset, oldNumberOfNodes](uint32 id) {
+      return offset[std::min(id, oldNumberOfNodes)];
+    };
+    offsetBuffer_.clear();
+    dataBuffer_.clear();
+    uint32 c = 0, m = 0;
+    for (uint32 id = lo; id < numberOfNodes; ) {
+      if (c < changedIds.size() && changedIds[c] == id) {
+        offsetBuffer_.push_back(dataBuffer_.size());
+        while (m < movedKeys_.size() && movedOwner(m) < id)
+          m++;
+        uint32 i = oldBegin(id), end = oldBegin(id + 1);
+        while (i < end || (m < movedKeys_.size() && movedOwner(m) == id)) {
+          if (i < end && owner(data[i]) != id) {
+            i++;
+            continue;
+          }
+          uint32 x;
+          if (m < movedKeys_.size() && movedOwner(m) == id && (i == end || movedItem(m) <= data[i])) {
+            x = movedItem(m++);
+            if (i < end && data[i] == x)
+              i++;
+          }
+          else {
+            x = data[i++];
+          }
+          dataBuffer_.push_back(x);
+        }
+        c++;
+        id++;
+        continue;
+      }
+
+      uint32 next = c < changedIds.size() ? std::min(changedIds[c], numberOfNodes) : numberOfNodes;
+      uint32 shift = dataBuffer_.size() - oldBegin(id);
+      for (uint32 j = id; j < next; j++)
+        offsetBuffer_.push_back(oldBegin(j) + shift);
+      dataBuffer_.insert(dataBuffer_.end(), data.begin() + oldBegin(id),
+        data.begin() + oldBegin(next));
+      id = next;
+    }
+    offsetBuffer_.push_back(dataBuffer_.size());
+
+    data.resize(base + dataBuffer_.size());
+    std::copy(dataBuffer_.begin(), dataBuffer_.end(), data.begin() + base);
+    offset.resize(numberOfNodes + 1);
+    for (uint32 i = 0; i < offsetBuffer_.size(); i++)
+      offset[lo + i] = base + offsetBuffer_[i];
+
+    for (uint32 id : changedIds)
+      changed[id] = false;
+    changedIds.clear();
+    moved.clear();
+  }
+
+  template<class WeightType>
+  void TreeUpdater<WeightType>::pushDown(MorphologicalTree<WeightType> &tree)
+  {
+    using MTree = MorphologicalTree<WeightType>;
+
+    // a node without an id, from the deepest, and the chain of its
+    // smallest children take their ids in increasing order down the chain:
+    // the i-th smallest is not greater than the smallest child of the i-th
+    // node, so it stays smaller than the ids of its other children. The
+    // chain stops at a leaf or at the first node greater than the pushed
+    // one, which keeps its id. The ids are first moved on "slot_", so each
+    // node is written once.
+    const uint32 numberOfNodes = tree.parent_.size();
+    moved_.resize(numberOfNodes, false);
+    slot_.resize(numberOfNodes);
+    movedHead_.resize(numberOfNodes, UNDEF);
+    movedNext_.resize(numberOfNodes);
+    movedNodes_.clear();
+    auto slot = [this](uint32 x) { return moved_[x] ? slot_[x] : x; };
+
+    for (uint32 r : pushedDown_) {
+      const uint32 id = newId_[r];
+      chain_.assign(1, id);
+      for (uint32 x = id; tree.numberOfChildren(x) > 0 && slot(x) <= id; ) {
+        // the smallest child: the first one not moved, or a moved one.
+        uint32 next = UNDEF;
+        for (uint32 c : tree.children(x)) {
+          if (!moved_[c]) {
+            next = c;
+            break;
+          }
+        }
+        for (uint32 c = movedHead_[x]; c != UNDEF; c = movedNext_[c]) {
+          if (next == UNDEF || slot_[c] < slot(next))
+            next = c;
+        }
+        x = next;
+        chain_.push_back(x);
+      }
+
+      chainId_.clear();
+      for (uint32 i = 1; i < chain_.size(); i++)
+        chainId_.push_back(slot(chain_[i]));
+      chainId_.insert(std::upper_bound(chainId_.begin(), chainId_.end(), id), id);
+      for (uint32 i = 0; i < chain_.size(); i++) {
+        uint32 x = chain_[i];
+        if (!moved_[x] && chainId_[i] != x) {
+          moved_[x] = true;
+          movedNodes_.push_back(x);
+          uint32 par = tree.parent_[x];
+          if (par != MTree::UndefinedIndex) {
+            movedNext_[x] = movedHead_[par];
+            movedHead_[par] = x;
+          }
+        }
+        if (moved_[x])
+          slot_[x] = chainId_[i];
+      }
+    }
+
+    nodeParent_.clear();
+    nodeLevel_.clear();
+    nodeRepresentative_.clear();
+    for (uint32 x : movedNodes_) {
+      uint32 par = tree.parent_[x];
+      nodeParent_.push_back(par == MTree::UndefinedIndex ? par : slot(par));
+      nodeLevel_.push_back(tree.level_[x]);
+      nodeRepresentative_.push_back(tree.representative_[x]);
+      if (par != MTree::UndefinedIndex)
+        movedHead_[par] = UNDEF;
+    }
+
+    for (uint32 i = 0; i < movedNodes_.size(); i++) {
+      uint32 x = movedNodes_[i], nid = slot_[x];
+      setParent(tree, nid, nodeParent_[i]);
+      tree.level_[nid] = nodeLevel_[i];
+      tree.representative_[nid] = nodeRepresentative_[i];
+      for (uint32 c : tree.children(x)) {
+        if (!moved_[c])
+          setParent(tree, c, nid);
+      }
+      for (uint32 p : tree.cnps(x))
+        setNode(tree, p, nid);
+    }
+
+    for (uint32 x : movedNodes_)
+      moved_[x] = false;
+  }
+
+  template<class WeightType>
+  void TreeUpdater<WeightType>::fillHoles(MorphologicalTree<WeightType> &tree)
+  {
+    // the largest hole h takes the last node whose parent is smaller than
+    // h (there is one: the smallest node after h), and the id of that node
+    // becomes the largest hole. The ids are top-down again once the holes
+    // are past the last node.
+    std::sort(holes_.begin(), holes_.end());
+    origin_.clear();
+    forward_.clear();
+    uint32 numberOfNodes = tree.parent_.size();
+    while (!holes_.empty()) {
+      uint32 h = holes_.back();
+      if (h == numberOfNodes - 1) {
+        holes_.pop_back();
+        numberOfNodes--;
+        continue;
+      }
+
+      uint32 x = numberOfNodes - 1;
+      while (tree.parent_[x] > h)
+        x--;
+
+      auto o = origin_.find(x);
+      uint32 source = o == origin_.end() ? x : o->second;
+      if (o != origin_.end())
+        origin_.erase(o);
+      setParent(tree, h, tree.parent_[x]);
+      tree.level_[h] = tree.level_[x];
+      tree.representative_[h] = tree.representative_[x];
+      for (uint32 c : tree.children(source)) {
+        auto f = forward_.find(c);
+        setParent(tree, f == forward_.end() ? c : f->second, h);
+      }
+      for (uint32 p : tree.cnps(source))
+        setNode(tree, p, h);
+      origin_[h] = source;
+      forward_[source] = h;
+      holes_.back() = x;
+    }
+
+    tree.parent_.resize(numberOfNodes);
+    tree.level_.resize(numberOfNodes);
+    tree.representative_.resize(numberOfNodes);
+  }
+
+  template<class WeightType>
+  void TreeUpdater<WeightType>::reset()
+  {
+    for (uint32 id : tornNodes_)
+      torn_[id] = false;
+    for (uint32 id : visited_)
+      subtreeRoot_[id] = UNDEF;
+    for (uint32 e : order_) {
+      if (e < numberOfNodes_)
+        inOrder_[e] = false;
+    }
+    for (uint32 x : evictedNodes_)
+      evicted_[x] = false;
+  }
+
+  template<class WeightType>
+  uint32 TreeUpdater<WeightType>::findRoot(uint32 x)
+  {
+    while (zpar_[x] != x) {
+      zpar_[x] = zpar_[zpar_[x]];
+      x = zpar_[x];
+    }
+    return x;
+  }
+
+  template<class WeightType>
+  void updateTree(MorphologicalTree<WeightType> &tree, const Box &domain,
+    std::shared_ptr<Adjacency> adj, const Box &region, const std::vector<WeightType> &values)
+  {
+    TreeUpdater<WeightType>{domain}.update(tree, adj, region, values);
+  }
+}
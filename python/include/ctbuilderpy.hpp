@@ -20,5 +20,6 @@ void bindCTBuilder(py::module &m, const std::string type)
   std::string className = type + "CTBuilder";
   py::class_<mt::CTBuilder<T>>(m, className.c_str())
     .def(py::init<>())
-    .def("build", &mt::CTBuilder<T>::build);
+    .def("build", py::overload_cast<const std::vector<T>&, std::shared_ptr<mt::Adjacency>,
+      std::vector<mt::uint32>>(&mt::CTBuilder<T>::build));
 }
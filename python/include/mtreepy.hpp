@@ -7,6 +7,9 @@
 #include "core/opaque_types.hpp"
 
 #include "morphotree/tree/mtree.hpp"
+#include "morphotree/tree/filteredTreeView.hpp"
+#include "morphotree/tree/ancestorIndex.hpp"
+#include "morphotree/tree/treeFile.hpp"
 
 namespace py = pybind11;
 namespace mt = morphotree;
@@ -17,6 +20,12 @@ void bindMTNode(py::module &m, const std::string& type);
 template<typename T>
 void bindMorphologicalTree(py::module &m, const std::string& type);
 
+template<typename T>
+void bindFilteredTreeView(py::module &m, const std::string& type);
+
+template<typename T>
+void bindAncestorIndex(py::module &m, const std::string& type);
+
 template<typename T>
 py::array MTNodeReconstructNumpy(mt::MTNode<T> *node);
 
@@ -40,10 +49,18 @@ py::array MorphologicalTreeReconstructImage(mt::MorphologicalTree<T> *tree,
 
 void bindMorphoTreeType(py::module &m);
 
+void bindNodeOrdering(py::module &m);
+
+void bindParallelEngine(py::module &m);
+
 void bindFoundamentalTypeMTNode(py::module &m);
 
 void bindFoundamentalTypeMorphologicalTree(py::module &m);
 
+void bindFoundamentalTypeFilteredTreeView(py::module &m);
+
+void bindFoundamentalTypeAncestorIndex(py::module &m);
+
 // =========================== [ MY IMPLEMENTATION ] ================================
 template<typename T>
 py::array MTNodeReconstructNumpy(mt::MTNode<T> *node)
@@ -102,30 +119,27 @@ template<typename T>
 void bindMTNode(py::module &m, const std::string &type)
 {
   std::string className = type + "MTNode";
-  py::class_<mt::MTNode<T>, std::shared_ptr<mt::MTNode<T>>>(m, className.c_str())
-    .def(py::init<mt::uint32>(), py::arg("id") = 0)
-    .def_property("id", py::overload_cast<>(&mt::MTNode<T>::id), py::overload_cast<mt::uint32>(&mt::MTNode<T>::id))
+  // nodes are owned by their tree: never hand ownership to Python and keep
+  // the tree alive while a node handle is referenced.
+  py::class_<mt::MTNode<T>, std::unique_ptr<mt::MTNode<T>, py::nodelete>>(m, className.c_str())
+    .def_property_readonly("id", &mt::MTNode<T>::id)
     .def_property("representative", 
-      py::overload_cast<>(&mt::MTNode<T>::representative), 
+      py::overload_cast<>(&mt::MTNode<T>::representative, py::const_), 
       py::overload_cast<mt::uint32>(&mt::MTNode<T>::representative))
-    .def_property("level", py::overload_cast<>(&mt::MTNode<T>::level), py::overload_cast<T>(&mt::MTNode<T>::level))
-    .def_property_readonly("cnps", &mt::MTNode<T>::cnps)
-    .def("appendCNP", &mt::MTNode<T>::appendCNP)
-    .def("includeCNPS", &mt::MTNode<T>::includeCNPS)
-    .def_property("parent", py::overload_cast<>(&mt::MTNode<T>::parent), 
-      py::overload_cast<typename mt::MTNode<T>::NodePtr>(&mt::MTNode<T>::parent))
-    .def("appendChild", &mt::MTNode<T>::appendChild)
-    .def("includeChildren", &mt::MTNode<T>::includeChildren)
-    .def("removeChild", &mt::MTNode<T>::removeChild)
-    .def_property_readonly("children", &mt::MTNode<T>::children)
+    .def_property("level", py::overload_cast<>(&mt::MTNode<T>::level, py::const_), py::overload_cast<T>(&mt::MTNode<T>::level))
+    .def_property_readonly("cnps", [](const mt::MTNode<T> &node) {
+      return std::vector<mt::uint32>(node.cnps()); })
+    .def_property_readonly("parent", &mt::MTNode<T>::parent, py::return_value_policy::reference_internal)
+    .def_property_readonly("children", [](const mt::MTNode<T> &node) {
+      return std::vector<typename mt::MTNode<T>::NodePtr>(node.children().begin(), node.children().end()); },
+      py::return_value_policy::reference_internal)
     .def("reconstruct", py::overload_cast<>(&mt::MTNode<T>::reconstruct, py::const_))
     .def("reconstruct", py::overload_cast<const mt::Box&>(&mt::MTNode<T>::reconstruct, py::const_))
     .def("reconstructGrey", py::overload_cast<const mt::Box&, T>(&mt::MTNode<T>::reconstructGrey, py::const_),
       py::arg("domain"), py::arg("backgroundValue") = 0)
     .def("reconstructGreyNumpy", &MTNodeReconstructGreyAsImageNumpy<T>, py::arg("domain"), py::arg("backgroundValue") = 0)
     .def("reconstructNumpy", &MTNodeReconstructNumpy<T>)
-    .def("reconstructNumpy", &MTNodeReconstructAsImageNumpy<T>)
-    .def("copy", &mt::MTNode<T>::copy);
+    .def("reconstructNumpy", &MTNodeReconstructAsImageNumpy<T>);
 }
 
 template<typename T>
@@ -137,8 +151,20 @@ void bindMorphologicalTree(py::module &m, const std::string& type)
   py::class_<mt::MorphologicalTree<T>>(m, className.c_str())
     .def(py::init<mt::MorphoTreeType>())
     .def(py::init<mt::MorphoTreeType, const std::vector<T>&, const mt::CTBuilderResult&>())
-    .def("node", py::overload_cast<mt::uint32>(&mt::MorphologicalTree<T>::node))
-    .def_property_readonly("root", py::overload_cast<>(&mt::MorphologicalTree<T>::root, py::const_))
+    .def("node", py::overload_cast<mt::uint32>(&mt::MorphologicalTree<T>::node), py::return_value_policy::reference_internal)
+    .def_property_readonly("root", py::overload_cast<>(&mt::MorphologicalTree<T>::root), py::return_value_policy::reference_internal)
+    .def("parent", &mt::MorphologicalTree<T>::parent)
+    .def("level", &mt::MorphologicalTree<T>::level)
+    .def("representative", &mt::MorphologicalTree<T>::representative)
+    .def("children", [](const mt::MorphologicalTree<T> &tree, mt::uint32 nodeId) {
+      return std::vector<mt::uint32>(tree.children(nodeId)); })
+    .def("numberOfChildren", &mt::MorphologicalTree<T>::numberOfChildren)
+    .def("cnps", [](const mt::MorphologicalTree<T> &tree, mt::uint32 nodeId) {
+      return std::vector<mt::uint32>(tree.cnps(nodeId)); })
+    .def_property_readonly("parents", &mt::MorphologicalTree<T>::parents)
+    .def_property_readonly("levels", &mt::MorphologicalTree<T>::levels)
+    .def_property_readonly("representatives", &mt::MorphologicalTree<T>::representatives)
+    .def_property_readonly("cmap", &mt::MorphologicalTree<T>::cmap)
     .def("reconstructNode", py::overload_cast<mt::uint32>(&mt::MorphologicalTree<T>::reconstructNode, py::const_))
     .def("reconstructNode", py::overload_cast<mt::uint32, const mt::Box&>(&mt::MorphologicalTree<T>::reconstructNode, py::const_))
     .def("reconstructNodeNumpy", &MorphologicalTreeReconstructNode<T>)
@@ -148,16 +174,88 @@ void bindMorphologicalTree(py::module &m, const std::string& type)
     .def("reconstructImage", py::overload_cast<>(&mt::MorphologicalTree<T>::reconstructImage, py::const_))    
     .def("reconstructImageWithFilter", py::overload_cast<std::function<bool(const NodePtr)>>(&mt::MorphologicalTree<T>::reconstructImage, py::const_))    
     .def("reconstructImageNumpy", &MorphologicalTreeReconstructImage<T>)
-    .def("idirectFilter", &mt::MorphologicalTree<T>::idirectFilter)
-    .def("directFilter", &mt::MorphologicalTree<T>::directFilter)
+    .def("idirectFilter", py::overload_cast<std::function<bool(const NodePtr)>>(&mt::MorphologicalTree<T>::idirectFilter))
+    .def("idirectFilter", py::overload_cast<const std::vector<bool>&>(&mt::MorphologicalTree<T>::idirectFilter))
+    .def("directFilter", py::overload_cast<std::function<bool(const NodePtr)>>(&mt::MorphologicalTree<T>::directFilter, py::const_))
+    .def("directFilter", py::overload_cast<const std::vector<bool>&>(&mt::MorphologicalTree<T>::directFilter, py::const_))
+    .def("directFilterWithMapping", [](const mt::MorphologicalTree<T> &tree, const std::vector<bool> &keep) {
+      std::vector<mt::uint32> newId;
+      mt::MorphologicalTree<T> ftree = tree.directFilter(keep, newId);
+      return std::make_pair(std::move(ftree), std::move(newId)); })
     .def("tranverseByLevel", py::overload_cast<std::function<void(typename mt::MorphologicalTree<T>::NodePtr)>>(&mt::MorphologicalTree<T>::traverseByLevel))
-    .def("smallComponent",  py::overload_cast<mt::uint32>(&mt::MorphologicalTree<T>::smallComponent))
+    .def("smallComponent",  py::overload_cast<mt::uint32>(&mt::MorphologicalTree<T>::smallComponent),
+      py::return_value_policy::reference_internal)
+    .def("smallComponents", &mt::MorphologicalTree<T>::smallComponents)
     .def("copy", &mt::MorphologicalTree<T>::copy)
-    .def_property_readonly("type", &mt::MorphologicalTree<T>::type);
+    .def_property_readonly("type", &mt::MorphologicalTree<T>::type)
+    .def("renumberDepthFirst", &mt::MorphologicalTree<T>::renumberDepthFirst)
+    .def_property_readonly("isDepthFirst", &mt::MorphologicalTree<T>::isDepthFirst)
+    .def("depth", &mt::MorphologicalTree<T>::depth)
+    .def("subtreeSize", &mt::MorphologicalTree<T>::subtreeSize)
+    .def_property_readonly("depths", &mt::MorphologicalTree<T>::depths)
+    .def_property_readonly("subtreeSizes", &mt::MorphologicalTree<T>::subtreeSizes)
+    .def_property_readonly("leaves", &mt::MorphologicalTree<T>::leaves)
+    .def("subtreeCNPs", [](const mt::MorphologicalTree<T> &tree, mt::uint32 nodeId) {
+      return std::vector<mt::uint32>(tree.subtreeCNPs(nodeId)); })
+    .def("isDescendant", &mt::MorphologicalTree<T>::isDescendant);
 
   std::string maxtreeName = type + "buildMaxTree";
-  m.def(maxtreeName.c_str(), &mt::buildMaxTree<T>);
+  m.def(maxtreeName.c_str(), &mt::buildMaxTree<T>, py::arg("f"), py::arg("adj"),
+    py::arg("ordering") = mt::NodeOrdering::LevelRoots, py::arg("numberOfThreads") = 1,
+    py::arg("engine") = mt::ParallelEngine::StripeMerge);
 
   std::string mintreeName = type + "buildMinTree";
-  m.def(mintreeName.c_str(), &mt::buildMinTree<T>);
+  m.def(mintreeName.c_str(), &mt::buildMinTree<T>, py::arg("f"), py::arg("adj"),
+    py::arg("ordering") = mt::NodeOrdering::LevelRoots, py::arg("numberOfThreads") = 1,
+    py::arg("engine") = mt::ParallelEngine::StripeMerge);
+
+  std::string maxAndMinTreesName = type + "buildMaxAndMinTrees";
+  m.def(maxAndMinTreesName.c_str(), [](const std::vector<T> &f, std::shared_ptr<mt::Adjacency> adj,
+    mt::NodeOrdering ordering, mt::uint32 numberOfThreads) {
+      mt::MaxAndMinTrees<T> trees = mt::buildMaxAndMinTrees(f, adj, ordering, numberOfThreads);
+      return std::make_pair(std::move(trees.maxTree), std::move(trees.minTree)); },
+    py::arg("f"), py::arg("adj"), py::arg("ordering") = mt::NodeOrdering::LevelRoots,
+    py::arg("numberOfThreads") = 1);
+
+  std::string saveTreeName = type + "saveTree";
+  m.def(saveTreeName.c_str(), [](const mt::MorphologicalTree<T> &tree, const mt::Box &domain,
+    const std::string &filename) { mt::TreeFileWriter<T>(tree, domain).write(filename); });
+
+  std::string loadTreeName = type + "loadTree";
+  m.def(loadTreeName.c_str(), [](const std::string &filename) { 
+    return mt::MappedTree<T>(filename).toTree(); });
+}
+
+template<typename T>
+void bindFilteredTreeView(py::module &m, const std::string& type)
+{
+  using ViewType = mt::FilteredTreeView<T>;
+
+  std::string className = type + "FilteredTreeView";
+  py::class_<ViewType>(m, className.c_str())
+    .def(py::init<const mt::MorphologicalTree<T>&, const std::vector<bool>&>(), py::keep_alive<1, 2>())
+    .def_property_readonly("numberOfNodes", &ViewType::numberOfNodes)
+    .def_property_readonly("keep", &ViewType::keep)
+    .def("isKept", &ViewType::isKept)
+    .def("keptNode", &ViewType::keptNode)
+    .def("parent", &ViewType::parent)
+    .def("parentNode", &ViewType::parentNode, py::return_value_policy::reference_internal)
+    .def("smallComponent", &ViewType::smallComponent, py::return_value_policy::reference_internal)
+    .def("reconstructImage", &ViewType::reconstructImage)
+    .def("materialise", py::overload_cast<>(&ViewType::materialise, py::const_));
+}
+
+template<typename T>
+void bindAncestorIndex(py::module &m, const std::string& type)
+{
+  using IndexType = mt::AncestorIndex<T>;
+
+  std::string className = type + "AncestorIndex";
+  py::class_<IndexType>(m, className.c_str())
+    .def(py::init<const mt::MorphologicalTree<T>&>(), py::keep_alive<1, 2>())
+    .def("depth", &IndexType::depth)
+    .def("ancestor", &IndexType::ancestor)
+    .def("lca", &IndexType::lca)
+    .def("isAncestor", &IndexType::isAncestor)
+    .def("levelAncestor", &IndexType::levelAncestor);
 }
\ No newline at end of file
@@ -165,25 +165,41 @@ PYBIND11_MODULE(morphotreepy, m)
     .def("I32STLsortIndex", &mt::STLsortIndex<mt::int32>)
     .def("I8STLsortIndex", &mt::STLsortIndex<mt::int8>);
 
-  m.def("UI32countingSortIncreasing", &mt::countingSortIncreasing<mt::uint32>)
-    .def("UI8countingSortIncreasing", &mt::countingSortIncreasing<mt::uint8>)
-    .def("I32countingSortIncreasing", &mt::countingSortIncreasing<mt::int32>)
-    .def("I8countingSortIncreasing", &mt::countingSortIncreasing<mt::int8>);
-
-  m.def("UI32countingSortDecreasing", &mt::countingSortDecreasing<mt::uint32>)
-    .def("UI8countingSortDecreasing", &mt::countingSortDecreasing<mt::uint8>)
-    .def("I32countingSortDecreasing", &mt::countingSortDecreasing<mt::int32>)
-    .def("I8countingSortDecreasing", &mt::countingSortDecreasing<mt::int8>); 
-
-  m.def("UI32sortIncreasing", &mt::sortIncreasing<mt::uint32>)
-    .def("UI8sortIncreasing", &mt::sortIncreasing<mt::uint8>)
-    .def("I32sortIncreasing", &mt::sortIncreasing<mt::int32>)
-    .def("I8sortIncreasing", &mt::sortIncreasing<mt::int8>); 
+  m.def("UI32countingSortIncreasing", &mt::countingSortIncreasing<mt::uint32>,
+      py::arg("v"), py::arg("numberOfThreads") = 1)
+    .def("UI8countingSortIncreasing", &mt::countingSortIncreasing<mt::uint8>,
+      py::arg("v"), py::arg("numberOfThreads") = 1)
+    .def("I32countingSortIncreasing", &mt::countingSortIncreasing<mt::int32>,
+      py::arg("v"), py::arg("numberOfThreads") = 1)
+    .def("I8countingSortIncreasing", &mt::countingSortIncreasing<mt::int8>,
+      py::arg("v"), py::arg("numberOfThreads") = 1);
+
+  m.def("UI32countingSortDecreasing", &mt::countingSortDecreasing<mt::uint32>,
+      py::arg("v"), py::arg("numberOfThreads") = 1)
+    .def("UI8countingSortDecreasing", &mt::countingSortDecreasing<mt::uint8>,
+      py::arg("v"), py::arg("numberOfThreads") = 1)
+    .def("I32countingSortDecreasing", &mt::countingSortDecreasing<mt::int32>,
+      py::arg("v"), py::arg("numberOfThreads") = 1)
+    .def("I8countingSortDecreasing", &mt::countingSortDecreasing<mt::int8>,
+      py::arg("v"), py::arg("numberOfThreads") = 1); 
+
+  m.def("UI32sortIncreasing", &mt::sortIncreasing<mt::uint32>,
+      py::arg("v"), py::arg("numberOfThreads") = 1)
+    .def("UI8sortIncreasing", &mt::sortIncreasing<mt::uint8>,
+      py::arg("v"), py::arg("numberOfThreads") = 1)
+    .def("I32sortIncreasing", &mt::sortIncreasing<mt::int32>,
+      py::arg("v"), py::arg("numberOfThreads") = 1)
+    .def("I8sortIncreasing", &mt::sortIncreasing<mt::int8>,
+      py::arg("v"), py::arg("numberOfThreads") = 1); 
  
-  m.def("UI32sortDecreasing", &mt::sortDecreasing<mt::uint32>)
-    .def("UI8sortDecreasing", &mt::sortDecreasing<mt::uint8>)
-    .def("I32sortDecreasing", &mt::sortDecreasing<mt::int32>)
-    .def("I8sortDecreasing", &mt::sortDecreasing<mt::int8>); 
+  m.def("UI32sortDecreasing", &mt::sortDecreasing<mt::uint32>,
+      py::arg("v"), py::arg("numberOfThreads") = 1)
+    .def("UI8sortDecreasing", &mt::sortDecreasing<mt::uint8>,
+      py::arg("v"), py::arg("numberOfThreads") = 1)
+    .def("I32sortDecreasing", &mt::sortDecreasing<mt::int32>,
+      py::arg("v"), py::arg("numberOfThreads") = 1)
+    .def("I8sortDecreasing", &mt::sortDecreasing<mt::int8>,
+      py::arg("v"), py::arg("numberOfThreads") = 1); 
 
   py::class_<mt::Adjacency, std::shared_ptr<mt::Adjacency>>(m, "Adjacency")
     .def("neighbours", &mt::Adjacency::neighbours);
@@ -215,9 +231,13 @@ PYBIND11_MODULE(morphotreepy, m)
     .def_readwrite("R", &mt::CTBuilderResult::R);
 
   bindMorphoTreeType(m);
+  bindNodeOrdering(m);
+  bindParallelEngine(m);
   bindFoundamentalTypeCTBuilder(m);
   bindFoundamentalTypeMTNode(m);
   bindFoundamentalTypeMorphologicalTree(m);
+  bindFoundamentalTypeFilteredTreeView(m);
+  bindFoundamentalTypeAncestorIndex(m);
 
   // tree of shapes
   bindFoundamentalTypeKeyValue(m);
@@ -8,6 +8,20 @@ void bindMorphoTreeType(py::module &m)
     .value("TreeOfShapes", mt::MorphoTreeType::TreeOfShapes);
 }
 
+void bindNodeOrdering(py::module &m)
+{
+  py::enum_<mt::NodeOrdering>(m, "NodeOrdering")
+    .value("LevelRoots", mt::NodeOrdering::LevelRoots)
+    .value("DepthFirst", mt::NodeOrdering::DepthFirst);
+}
+
+void bindParallelEngine(py::module &m)
+{
+  py::enum_<mt::ParallelEngine>(m, "ParallelEngine")
+    .value("StripeMerge", mt::ParallelEngine::StripeMerge)
+    .value("ConcurrentUnionFind", mt::ParallelEngine::ConcurrentUnionFind);
+}
+
 
 void bindFoundamentalTypeMTNode(py::module &m)
 {
@@ -23,4 +37,20 @@ void bindFoundamentalTypeMorphologicalTree(py::module &m)
   bindMorphologicalTree<mt::uint32>(m, "UI32");
   bindMorphologicalTree<mt::int8>(m, "I8");
   bindMorphologicalTree<mt::int32>(m, "I32");
+}
+
+void bindFoundamentalTypeFilteredTreeView(py::module &m)
+{
+  bindFilteredTreeView<mt::uint8>(m, "UI8");
+  bindFilteredTreeView<mt::uint32>(m, "UI32");
+  bindFilteredTreeView<mt::int8>(m, "I8");
+  bindFilteredTreeView<mt::int32>(m, "I32");
+}
+
+void bindFoundamentalTypeAncestorIndex(py::module &m)
+{
+  bindAncestorIndex<mt::uint8>(m, "UI8");
+  bindAncestorIndex<mt::uint32>(m, "UI32");
+  bindAncestorIndex<mt::int8>(m, "I8");
+  bindAncestorIndex<mt::int32>(m, "I32");
 }
\ No newline at end of file
@@ -7,18 +7,16 @@ namespace morphotree
      offset_{                 I32Point{0,-1},
               I32Point{-1,0},                  I32Point{1,0},
                               I32Point{0,1}}
-  {}
+  {
+    for (uint32 i = 0; i < offset_.size(); i++)
+      indexOffset_[i] = offset_[i].y() * static_cast<int32>(domain_.width()) + offset_[i].x();
+  }
 
   std::vector<uint32> Adjacency4C::neighbours(uint32 v) const 
   {
     std::vector<uint32> neighbours;
-    I32Point p = domain_.indexToPoint(v);
-    for (const I32Point &q : offset_) {
-      I32Point n = p + q;
-      if (domain_.contains(n)){
-        neighbours.push_back(domain_.pointToIndex(n));
-      }
-    }
+    neighbours.reserve(offset_.size());
+    forEachNeighbour(v, [&neighbours](uint32 n) { neighbours.push_back(n); });
     return neighbours;
   }
 
@@ -27,16 +25,16 @@ namespace morphotree
      offset_{                 I32Point{0,-1},
               I32Point{-1,0},                  I32Point{1,0},
                               I32Point{0,1}}
-  {}
+  {
+    for (uint32 i = 0; i < offset_.size(); i++)
+      indexOffset_[i] = offset_[i].y() * static_cast<int32>(domain_.width()) + offset_[i].x();
+  }
 
   std::vector<uint32> InfAdjacency4C::neighbours(uint32 v) const 
   {
     std::vector<uint32> neighbours;
-    I32Point p = domain_.indexToPoint(v);
-    for (const I32Point &q : offset_) {
-      I32Point n = p + q;
-      neighbours.push_back(domain_.pointToIndex(n));
-    }
+    neighbours.reserve(offset_.size());
+    forEachNeighbour(v, [&neighbours](uint32 n) { neighbours.push_back(n); });
     return neighbours;
   }
 }
\ No newline at end of file
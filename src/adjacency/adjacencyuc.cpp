@@ -1,47 +1,34 @@
 #include "morphotree/adjacency/adjacencyuc.hpp"
 
+#include <algorithm>
+
 namespace morphotree
 {
   AdjacencyUC::AdjacencyUC(Box imgdomain)
     :domain_{imgdomain},
-     offset_{I32Point{-1,0}, I32Point{0,-1}, I32Point{1,0}, I32Point{0, 1}}
+     offset_{I32Point{-1,0}, I32Point{0,-1}, I32Point{1,0}, I32Point{0, 1}},
+     diagonalOffset_{I32Point{1,-1}, I32Point{-1,-1}, I32Point{-1,1}, I32Point{1,1}},
+     diagonal_{DiagonalConnection::NE, DiagonalConnection::NW, DiagonalConnection::SW,
+               DiagonalConnection::SE}
   {
+    const int32 width = domain_.width();
+    for (uint32 i = 0; i < offset_.size(); i++) {
+      indexOffset_[i] = offset_[i].y() * width + offset_[i].x();
+      indexOffset_[offset_.size() + i] = diagonalOffset_[i].y() * width + diagonalOffset_[i].x();
+    }
     dconn_.resize(domain_.numberOfPoints(), DiagonalConnection::None);
   }
 
+  void AdjacencyUC::clearDiagonalConnections()
+  {
+    std::fill(dconn_.begin(), dconn_.end(), DiagonalConnection::None);
+  }
+
   std::vector<uint32> AdjacencyUC::neighbours(uint32 v) const
   {
     std::vector<uint32> n;
-
-    I32Point p = domain_.indexToPoint(v);
-    for (const I32Point &q : offset_) {
-      I32Point r = p + q;
-      if (domain_.contains(r))
-        n.push_back(domain_.pointToIndex(p + q));
-    }
-
-    DiagonalConnection curDconn = dconn_[v];
-    if ((curDconn & DiagonalConnection::NE)) {
-      I32Point r = p + I32Point{1, -1};
-      if (domain_.contains(r)) 
-        n.push_back(domain_.pointToIndex(r));
-    }
-    if ((curDconn & DiagonalConnection::NW)) {
-      I32Point r = p + I32Point{-1, -1};
-      if (domain_.contains(r))
-        n.push_back(domain_.pointToIndex(r));
-    }
-    if ((curDconn & DiagonalConnection::SW)) {
-      I32Point r = p + I32Point{-1, +1};
-      if (domain_.contains(r))
-        n.push_back(domain_.pointToIndex(r));
-    }
-    if ((curDconn & DiagonalConnection::SE)) {
-      I32Point r = p + I32Point{ +1, +1};
-      if (domain_.contains(r)) 
-        n.push_back(domain_.pointToIndex(r));
-    }
-
+    n.reserve(indexOffset_.size());
+    forEachNeighbour(v, [&n](uint32 q) { n.push_back(q); });
     return n;
   }
 }
\ No newline at end of file
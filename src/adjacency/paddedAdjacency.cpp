@@ -0,0 +1,36 @@
+#include "morphotree/adjacency/paddedAdjacency.hpp"
+
+namespace morphotree
+{
+  PaddedAdjacency4C::PaddedAdjacency4C(Box imgdomain)
+  {
+    const int32 stride = imgdomain.width() + 2;
+    offset_ = {           -stride,
+                      -1,            1,
+                           stride       };
+  }
+
+  std::vector<uint32> PaddedAdjacency4C::neighbours(uint32 v) const
+  {
+    std::vector<uint32> neighbours;
+    neighbours.reserve(offset_.size());
+    forEachNeighbour(v, [&neighbours](uint32 n) { neighbours.push_back(n); });
+    return neighbours;
+  }
+
+  PaddedAdjacency8C::PaddedAdjacency8C(Box imgdomain)
+  {
+    const int32 stride = imgdomain.width() + 2;
+    offset_ = { -stride - 1, -stride, -stride + 1,
+                         -1,                    1,
+                 stride - 1,  stride,  stride + 1 };
+  }
+
+  std::vector<uint32> PaddedAdjacency8C::neighbours(uint32 v) const
+  {
+    std::vector<uint32> neighbours;
+    neighbours.reserve(offset_.size());
+    forEachNeighbour(v, [&neighbours](uint32 n) { neighbours.push_back(n); });
+    return neighbours;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#include "morphotree/core/copyCounter.hpp"
+
+namespace morphotree
+{
+  uint64 CopyCounter::count()
+  {
+    return counter().load(std::memory_order_relaxed);
+  }
+
+  void CopyCounter::reset()
+  {
+    counter().store(0, std::memory_order_relaxed);
+  }
+
+  std::atomic<uint64>& CopyCounter::counter()
+  {
+    static std::atomic<uint64> copies{0};
+    return copies;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include "morphotree/core/hierarchicalQueue.hpp"
+
+namespace morphotree
+{
+  HierarchicalQueue::HierarchicalQueue()
+    :top_{0}, size_{0}
+  {}
+
+  HierarchicalQueue::HierarchicalQueue(const std::vector<uint32> &levelCapacity)
+    :top_{0}, size_{0}
+  {
+    reset(levelCapacity);
+  }
+
+  void HierarchicalQueue::reset(const std::vector<uint32> &levelCapacity)
+  {
+    begin_.resize(levelCapacity.size());
+    end_.resize(levelCapacity.size());
+    levelBits_.assign((levelCapacity.size() + 63) / 64, 0);
+    wordBits_.assign((levelCapacity.size() + 4095) / 4096, 0);
+    top_ = 0;
+    size_ = 0;
+
+    uint32 capacity = 0;
+    for (uint32 level = 0; level < levelCapacity.size(); level++) {
+      begin_[level] = end_[level] = capacity;
+      capacity += levelCapacity[level];
+    }
+    data_.resize(capacity);
+  }
+
+  void HierarchicalQueue::updateTopLevel()
+  {
+    // the level "top_" has just been emptied and no level above it is in use.
+    uint32 word = top_ >> 6;
+    levelBits_[word] &= ~(uint64(1) << (top_ & 63));
+    if (levelBits_[word] != 0) {
+      top_ = (word << 6) | highestBit(levelBits_[word]);
+      return;
+    }
+
+    wordBits_[word >> 6] &= ~(uint64(1) << (word & 63));
+    for (uint32 group = (word >> 6) + 1; group > 0; group--) {
+      if (wordBits_[group - 1] != 0) {
+        word = ((group - 1) << 6) | highestBit(wordBits_[group - 1]);
+        top_ = (word << 6) | highestBit(levelBits_[word]);
+        return;
+      }
+    }
+    top_ = 0;
+  }
+}
\ No newline at end of file
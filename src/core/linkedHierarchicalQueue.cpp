@@ -0,0 +1,75 @@
+#include "morphotree/core/linkedHierarchicalQueue.hpp"
+
+#include <limits>
+
+namespace morphotree
+{
+  const uint32 LinkedHierarchicalQueue::Empty = std::numeric_limits<uint32>::max();
+
+  LinkedHierarchicalQueue::LinkedHierarchicalQueue()
+    :size_{0}
+  {}
+
+  LinkedHierarchicalQueue::LinkedHierarchicalQueue(uint32 numberOfLevels, uint32 numberOfElements)
+    :size_{0}
+  {
+    reset(numberOfLevels, numberOfElements);
+  }
+
+  void LinkedHierarchicalQueue::reset(uint32 numberOfLevels, uint32 numberOfElements)
+  {
+    head_.assign(numberOfLevels, Empty);
+    tail_.resize(numberOfLevels);
+    next_.resize(numberOfElements);
+    size_ = 0;
+  }
+
+  LinkedHierarchicalQueue::KeyValueType LinkedHierarchicalQueue::pop(uint32 level)
+  {
+    uint32 found;
+    if (isEmpty() || !findClosestNonEmptyLevel(level, found))
+      return KeyValueType();
+
+    uint32 v = head_[found];
+    head_[found] = next_[v];
+    size_--;
+    return KeyValueType{found, v};
+  }
+
+  bool LinkedHierarchicalQueue::findClosestNonEmptyLevel(uint32 level, uint32 &found) const
+  {
+    const int32 numberOfLevels = head_.size();
+    if (head_[level] != Empty) {
+      found = level;
+      return true;
+    }
+
+    int32 l = static_cast<int32>(level) - 1;
+    int32 u = static_cast<int32>(level) + 1;
+    for (; 0 <= l && u < numberOfLevels; l--, u++) {
+      if (head_[l] != Empty) {
+        found = l;
+        return true;
+      }
+      if (head_[u] != Empty) {
+        found = u;
+        return true;
+      }
+    }
+
+    for (; 0 <= l; l--) {
+      if (head_[l] != Empty) {
+        found = l;
+        return true;
+      }
+    }
+
+    for (; u < numberOfLevels; u++) {
+      if (head_[u] != Empty) {
+        found = u;
+        return true;
+      }
+    }
+    return false;
+  }
+}
\ No newline at end of file
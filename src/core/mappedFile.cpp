@@ -0,0 +1,108 @@
+#include "morphotree/core/mappedFile.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace morphotree
+{
+  MappedFile::MappedFile()
+    :data_{nullptr}, size_{0}, mapped_{false}
+  {}
+
+  MappedFile::MappedFile(const std::string &filename)
+    :data_{nullptr}, size_{0}, mapped_{false}
+  {
+    open(filename);
+  }
+
+  MappedFile::MappedFile(MappedFile &&other)
+    :data_{other.data_}, size_{other.size_}, mapped_{other.mapped_}, 
+     buffer_{std::move(other.buffer_)}
+  {
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.mapped_ = false;
+  }
+
+  MappedFile& MappedFile::operator=(MappedFile &&other)
+  {
+    if (this != &other) {
+      close();
+      data_ = other.data_;
+      size_ = other.size_;
+      mapped_ = other.mapped_;
+      buffer_ = std::move(other.buffer_);
+
+      other.data_ = nullptr;
+      other.size_ = 0;
+      other.mapped_ = false;
+    }
+    return *this;
+  }
+
+  MappedFile::~MappedFile()
+  {
+    close();
+  }
+
+  void MappedFile::open(const std::string &filename)
+  {
+    close();
+
+#if !defined(_WIN32)
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("could not open " + filename);
+
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+      void *addr = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        data_ = static_cast<const char*>(addr);
+        size_ = static_cast<std::size_t>(st.st_size);
+        mapped_ = true;
+      }
+    }
+    ::close(fd);
+
+    if (mapped_)
+      return;
+#endif
+
+    std::ifstream in{filename, std::ios::binary | std::ios::ate};
+    if (!in)
+      throw std::runtime_error("could not open " + filename);
+
+    buffer_.resize(static_cast<std::size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(buffer_.data(), buffer_.size());
+    if (!in)
+      throw std::runtime_error("could not read " + filename);
+
+    // an empty file is still open.
+    if (buffer_.empty())
+      buffer_.reserve(1);
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+  }
+
+  void MappedFile::close()
+  {
+#if !defined(_WIN32)
+    if (mapped_)
+      ::munmap(const_cast<char*>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    buffer_.clear();
+    buffer_.shrink_to_fit();
+  }
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "morphotree/core/rasterFile.hpp"
+
+#include <cctype>
+
+namespace morphotree
+{
+  RasterFile::RasterFile(const std::string &filename, Format format, uint32 width, uint32 height,
+    uint32 channels, uint32 bytesPerSample, std::uint64_t offset)
+    :in_{filename, std::ios::binary}, filename_{filename}, format_{format}, width_{width},
+     height_{height}, channels_{channels}, bytesPerSample_{bytesPerSample}, offset_{offset}
+  {
+    if (!in_)
+      throw std::runtime_error("could not open raster file " + filename);
+
+    in_.seekg(0, std::ios::end);
+    std::uint64_t size = static_cast<std::uint64_t>(in_.tellg());
+    std::uint64_t expected = offset_ + std::uint64_t(width_) * height_ * channels_ * bytesPerSample_;
+    if (size < expected)
+      throw std::runtime_error("raster file " + filename + " is too short for its size");
+  }
+
+  RasterFile RasterFile::openRaw(const std::string &filename, uint32 width, uint32 height,
+    uint32 bytesPerSample, std::uint64_t offset)
+  {
+    return RasterFile{filename, Format::Raw, width, height, 1, bytesPerSample, offset};
+  }
+
+  RasterFile RasterFile::openPNM(const std::string &filename)
+  {
+    std::ifstream in{filename, std::ios::binary};
+    if (!in)
+      throw std::runtime_error("could not open raster file " + filename);
+
+    char magic[2] = {0, 0};
+    in.read(magic, 2);
+    if (magic[0] != 'P' || (magic[1] != '5' && magic[1] != '6'))
+      throw std::runtime_error(filename + " is not a binary PGM or PPM file");
+
+    // the header fields are separated by whitespace and comments, and
+    // followed by a single whitespace character before the samples.
+    auto readField = [&in, &filename]() {
+      int c = in.get();
+      while (c != EOF && (std::isspace(c) || c == '#')) {
+        if (c == '#') {
+          while (c != EOF && c != '\n')
+            c = in.get();
+        }
+        c = in.get();
+      }
+
+      std::uint64_t value = 0;
+      if (!std::isdigit(c))
+        throw std::runtime_error("invalid header in " + filename);
+      while (std::isdigit(c)) {
+        value = value * 10 + (c - '0');
+        c = in.get();
+      }
+      return value;
+    };
+
+    std::uint64_t width = readField();
+    std::uint64_t height = readField();
+    std::uint64_t maxValue = readField();
+    if (width == 0 || height == 0 || maxValue == 0 || maxValue > 65535)
+      throw std::runtime_error("invalid header in " + filename);
+
+    std::uint64_t offset = static_cast<std::uint64_t>(in.tellg());
+    Format format = magic[1] == '5' ? Format::PGM : Format::PPM;
+    return RasterFile{filename, format, static_cast<uint32>(width), static_cast<uint32>(height),
+      format == Format::PGM ? 1u : 3u, maxValue < 256 ? 1u : 2u, offset};
+  }
+
+  const char* RasterFile::readRow(uint32 x, uint32 y, uint32 count)
+  {
+    const std::uint64_t pixelBytes = channels_ * bytesPerSample_;
+    row_.resize(count * pixelBytes);
+    in_.seekg(offset_ + (std::uint64_t(y) * width_ + x) * pixelBytes);
+    in_.read(row_.data(), row_.size());
+    if (!in_)
+      throw std::runtime_error("could not read raster file " + filename_);
+    return row_.data();
+  }
+
+  void RasterFile::checkWindow(const Box &window) const
+  {
+    if (window.left() < 0 || window.top() < 0 || window.right() >= int32(width_) ||
+        window.bottom() >= int32(height_))
+      throw std::runtime_error("window outside the domain of raster file " + filename_);
+  }
+
+  double RasterFile::pnmValue(const char *pixel) const
+  {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char*>(pixel);
+    double sample[3];
+    for (uint32 c = 0; c < channels_; c++) {
+      sample[c] = bytesPerSample_ == 1 ? bytes[c]
+                                       : (bytes[2*c] << 8) | bytes[2*c + 1];
+    }
+    return channels_ == 1 ? sample[0]
+                          : 0.299 * sample[0] + 0.587 * sample[1] + 0.114 * sample[2];
+  }
+}
\ No newline at end of file